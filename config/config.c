@@ -87,6 +87,8 @@ Settings config = {
     .sort                      = FALSE,
     /** Use levenshtein sorting when matching */
     .sorting_method            = "normal",
+    /** Characters of an entry scored by the fzf sorting method */
+    .sorting_max_length        = 1024,
     /** Case sensitivity of the search */
     .case_sensitive            = FALSE,
     /** Cycle through in the element list */
@@ -42,6 +42,14 @@
  */
 int dmenu_switcher_dialog ( void );
 
+/**
+ * Read the entries, filter them on the -filter input and print the matches to
+ * stdout, ranked when sorting is enabled. Does not need a display.
+ *
+ * @returns EXIT_SUCCESS if one or more entries matched, EXIT_FAILURE otherwise.
+ */
+int dmenu_filter_stdout ( void );
+
 /**
  * Print dmenu mode commandline options to stdout, for use in help menu.
  */
@@ -1,30 +1,43 @@
 #ifndef ROFI_DIALOGS_DMENU_SCRIPT_SHARED_H
 #define ROFI_DIALOGS_DMENU_SCRIPT_SHARED_H
 
+/** Size of the chunks the strings of the entries are allocated from. */
+#define DMENU_SCRIPT_STRINGS_CHUNK_SIZE    65536
+
+/**
+ * A row of dmenu or script mode.
+ * The strings are owned by the mode, kept in its string chunk, not by the entry.
+ * Fields are ordered to avoid padding, the list is scanned sequentially while matching.
+ */
 typedef struct
 {
-    /** Entry content. (visible part) */
-    char     *entry;
+    /** Entry content. (visible part, not terminated when used in place) */
+    char         *entry;
+    /** Length of entry in characters. */
+    unsigned int entry_length;
+    /** Length of entry in bytes. */
+    unsigned int entry_size;
     /** Icon name to display. */
-    char     *icon_name;
-    /** Async icon fetch handler. */
-    uint32_t icon_fetch_uid;
+    char         *icon_name;
     /** Hidden meta keywords. */
-    char     *meta;
+    char         *meta;
 
     /** info */
-    char     *info;
+    char         *info;
 
+    /** Async icon fetch handler. */
+    uint32_t     icon_fetch_uid;
     /** non-selectable */
-    gboolean nonselectable;
+    gboolean     nonselectable;
 } DmenuScriptEntry;
 /**
  * @param sw Unused
+ * @param strings The string chunk the parsed values are stored in.
  * @param entry The entry to update.
- * @param buffer The buffer to parse.
- * @param length The buffer length.
+ * @param buffer The buffer to parse, it is not modified.
+ * @param length The buffer length, parsing also stops at a '\0'.
  *
  * Updates entry with the parsed values from buffer.
  */
-void dmenuscript_parse_entry_extras ( G_GNUC_UNUSED Mode *sw, DmenuScriptEntry *entry, char *buffer, size_t length );
+void dmenuscript_parse_entry_extras ( G_GNUC_UNUSED Mode *sw, GStringChunk *strings, DmenuScriptEntry *entry, const char *buffer, size_t length );
 #endif // ROFI_DIALOGS_DMENU_SCRIPT_SHARED_H
@@ -45,6 +45,17 @@
  */
 PangoAttrList *helper_token_match_get_pango_attr ( RofiHighlightColorStyle th, rofi_int_matcher **tokens, const char *input, PangoAttrList *retv );
 
+/**
+ * @param th The RofiHighlightColorStyle
+ * @param ranges Array of #rofi_range_pair as returned by #helper_token_match_get_ranges (can be NULL)
+ * @param retv The Attribute list to update with matches
+ *
+ * Creates a set of pango attributes highlighting the ranges, without matching again.
+ *
+ * @returns the updated retv list.
+ */
+PangoAttrList *helper_token_match_set_pango_attr_ranges ( RofiHighlightColorStyle th, const GArray *ranges, PangoAttrList *retv );
+
 /**
  * @param pfd Pango font description to validate.
  * @param font The name of the font to check.
@@ -70,6 +70,11 @@ rofi_int_matcher **helper_tokenize ( const char *input, int case_sensitive );
  */
 void helper_tokenize_free ( rofi_int_matcher ** tokens );
 
+/**
+ * Free the compiled matchers kept by #helper_tokenize for reuse.
+ */
+void helper_tokenize_cache_clear ( void );
+
 /**
  * @param key The key to search for
  * @param val Pointer to the string to set to the key value (if found)
@@ -137,6 +142,169 @@ int find_arg ( const char * const key );
  * @returns TRUE when matches, FALSE otherwise
  */
 int helper_token_match ( rofi_int_matcher * const *tokens, const char *input );
+
+/**
+ * @param tokens  List of (input) tokens to match.
+ * @param input   The entry to match against, does not need to be terminated.
+ * @param length  The length of input in bytes, or -1 if input is terminated.
+ *
+ * Tokenized match, match tokens to the first length bytes of input.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_token_match_len ( rofi_int_matcher * const *tokens, const char *input, gssize length );
+
+/**
+ * @param tokens  List of (input) tokens to match.
+ * @param input   The string to find the matches on.
+ *
+ * Find the parts of input matched by the (not negated) tokens, these are highlighted when displayed.
+ *
+ * @returns an array of #rofi_range_pair in bytes (free with g_array_free), or NULL if highlighting is not supported.
+ */
+GArray *helper_token_match_get_ranges ( rofi_int_matcher **tokens, const char *input );
+/**
+ * Cache holding the strings of a mode in the form they are matched:
+ * normalized (with normalize-match) and case folded (when case insensitive).
+ * Built once when the strings are loaded, so this work is not repeated for
+ * every row on every keystroke. The mode can hand it out as #RofiStringTable.
+ * When the strings are matched as they are, the cache refers to the strings of
+ * the mode instead of copying them.
+ */
+typedef struct _RofiMatchCache RofiMatchCache;
+
+/**
+ * Create a cache for the current matching settings.
+ *
+ * @returns a new cache.
+ */
+RofiMatchCache *helper_match_cache_new ( void );
+
+/**
+ * @param cache The cache to free (can be NULL)
+ *
+ * Free the cache and the strings it holds.
+ */
+void helper_match_cache_free ( RofiMatchCache *cache );
+
+/**
+ * @param cache The cache (can be NULL)
+ * @param str The string to add, NULL for a row without string.
+ * @param length The length of str in bytes, or -1 if str is terminated.
+ *
+ * Add the next row to the cache. When the strings are matched as they are, str is
+ * not copied, it has to stay valid as long as the cache is used.
+ */
+void helper_match_cache_add ( RofiMatchCache *cache, const char *str, gssize length );
+
+/**
+ * @param cache The cache (can be NULL)
+ * @param index The row
+ *
+ * @returns the string of row index as it is matched (not terminated when it is not copied), or NULL if not available.
+ */
+const char *helper_match_cache_get ( const RofiMatchCache *cache, unsigned int index );
+
+/**
+ * @param cache The cache (can be NULL)
+ * @param tokens List of (input) tokens to match.
+ * @param index The row
+ *
+ * Check if row index can be matched against the cache with tokens, for
+ * example case sensitive tokens cannot be matched against case folded strings.
+ *
+ * @returns TRUE if #helper_match_cache_token_match can be used.
+ */
+gboolean helper_match_cache_usable ( const RofiMatchCache *cache, rofi_int_matcher * const *tokens, unsigned int index );
+
+/**
+ * @param cache The cache
+ * @param tokens List of (input) tokens to match.
+ * @param index The row to match
+ *
+ * Tokenized match against the cached string of row index.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_match_cache_token_match ( const RofiMatchCache *cache, rofi_int_matcher * const *tokens, unsigned int index );
+
+/**
+ * @param cache The cache (can be NULL)
+ *
+ * @returns the strings in the cache as table, valid until the cache is modified or freed.
+ */
+const RofiStringTable *helper_match_cache_get_table ( const RofiMatchCache *cache );
+
+/**
+ * @param table The string table (can be NULL)
+ * @param tokens List of (input) tokens to match.
+ *
+ * Check if the strings in the table can be matched with tokens, for example case
+ * sensitive tokens cannot be matched against case folded strings.
+ *
+ * @returns TRUE if #helper_string_table_token_match can be used.
+ */
+gboolean helper_string_table_usable ( const RofiStringTable *table, rofi_int_matcher * const *tokens );
+
+/**
+ * @param table The string table
+ * @param tokens List of (input) tokens to match.
+ * @param index The entry to match
+ *
+ * Tokenized match against the string of entry index in the table.
+ *
+ * @returns TRUE when matches, FALSE otherwise
+ */
+int helper_string_table_token_match ( const RofiStringTable *table, rofi_int_matcher * const *tokens, unsigned int index );
+
+/**
+ * Trigram index over the strings of a mode, used to find the rows that can match
+ * the literal tokens without matching every row.
+ */
+typedef struct _RofiTrigramIndex RofiTrigramIndex;
+
+/**
+ * @param data User data
+ * @param index The row
+ * @param field The string of the row to get, counting from 0
+ * @param length Set to the length of the string in bytes [out]
+ *
+ * Get the strings a row is matched on, a row can have multiple (e.g. entry and meta).
+ *
+ * @returns the string (does not need to be terminated), or NULL if the row has no more strings.
+ */
+typedef const char * ( *RofiTrigramIndexGetString )( gpointer data, unsigned int index, unsigned int field, gsize *length );
+
+/**
+ * @param length The number of rows
+ * @param get_string Function returning the strings of a row
+ * @param data User data passed to get_string
+ * @param cancel When set (to non-zero) the build is aborted (can be NULL)
+ *
+ * Build the index, this can be called from a worker thread as long as the strings do not change.
+ *
+ * @returns the index, or NULL if cancelled or the input is too large to index.
+ */
+RofiTrigramIndex *helper_trigram_index_new ( unsigned int length, RofiTrigramIndexGetString get_string, gpointer data, const gint *cancel );
+
+/**
+ * @param index The index to free (can be NULL)
+ *
+ * Free the index.
+ */
+void helper_trigram_index_free ( RofiTrigramIndex *index );
+
+/**
+ * @param index The index (can be NULL)
+ * @param tokens List of (input) tokens to match.
+ * @param length Set to the number of candidates [out]
+ *
+ * Look up the rows that hold all trigrams of the normal and prefix tokens. Regex, glob, fuzzy
+ * and negated tokens are not looked up, these still have to be matched on every candidate.
+ *
+ * @returns a sorted array of candidate rows (free with g_free), or NULL if the tokens rule out no row.
+ */
+unsigned int *helper_trigram_index_candidates ( const RofiTrigramIndex *index, rofi_int_matcher * const *tokens, unsigned int *length );
 /**
  * @param cmd The command to execute.
  *
@@ -160,12 +328,14 @@ int create_pid_file ( const char *pidfile );
 void remove_pid_file ( int fd );
 
 /**
+ * @param check_display Also check the settings that need the display, like the monitor.
+ *
  * Do some input validation, especially the first few could break things.
  * It is good to catch them beforehand.
  *
- * This functions exits the program with 1 when it finds an invalid configuration.
+ * @returns TRUE when it finds an invalid configuration, the errors are added with #rofi_add_error_message.
  */
-int config_sanity_check ( void );
+int config_sanity_check ( gboolean check_display );
 
 /**
  * @param arg string to parse.
@@ -259,6 +429,9 @@ gchar *rofi_escape_markup ( gchar *text );
  *  The first dimension can be suppressed since we do not need a matching scheme, which reduces the space complexity from
  *  O(N*M) to O(M)
  *
+ *  Strings that `pattern` is not a subsequence of are rejected before the alignment. Only the first
+ *  Settings::sorting_max_length characters, starting at the first character that can align with `pattern`, are scored.
+ *
  * @returns the sorting weight.
  */
 int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen );
@@ -31,7 +31,7 @@
 G_BEGIN_DECLS
 
 /** ABI version to check if loaded plugin is compatible. */
-#define ABI_VERSION    0x00000006
+#define ABI_VERSION    0x0000000a
 
 /**
  * @param data Pointer to #Mode object.
@@ -73,6 +73,19 @@ typedef cairo_surface_t * ( *_mode_get_icon )( const Mode *sw, unsigned int sele
  */
 typedef char * ( *_mode_get_completion )( const Mode *sw, unsigned int selected_line );
 
+/**
+ * @param sw The #Mode pointer
+ * @param selected_line The selected line
+ * @param length Set to the length of the string in characters [out]
+ *
+ * Get the completion string without copying it, used to score rows while
+ * filtering. This is called from the filter threads. Only length characters
+ * are read, the string does not need to be terminated.
+ *
+ * @returns the string owned by the mode, or NULL to fall back to #_mode_get_completion.
+ */
+typedef const char * ( *_mode_peek_completion )( const Mode *sw, unsigned int selected_line, glong *length );
+
 /**
  * @param tokens  List of (input) tokens to match.
  * @param input   The entry to match against.
@@ -86,6 +99,42 @@ typedef char * ( *_mode_get_completion )( const Mode *sw, unsigned int selected_
  */
 typedef int ( *_mode_token_match )( const Mode *data, rofi_int_matcher **tokens, unsigned int index );
 
+/**
+ * @param sw The #Mode pointer
+ * @param tokens List of (input) tokens to match.
+ * @param start The first row to match.
+ * @param stop The row after the last row to match.
+ * @param out Filled with the matching rows, in order, room for stop - start rows [out]
+ * @param count Set to the number of matching rows [out]
+ *
+ * Match a range of rows in one call, so the mode can loop over its own entries
+ * and do its setup once. Optional, #_mode_token_match is used per row if not set.
+ */
+typedef void ( *_mode_token_match_batch )( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count );
+
+/**
+ * @param sw The #Mode pointer
+ * @param tokens List of (input) tokens to match.
+ * @param length Set to the number of candidates [out]
+ *
+ * Look up the rows that can match tokens in an index kept by the mode, so only these
+ * have to be passed to the token match.
+ *
+ * @returns a sorted array of rows (free with g_free), or NULL to match all rows.
+ */
+typedef unsigned int * ( *_mode_token_candidates )( const Mode *sw, rofi_int_matcher **tokens, unsigned int *length );
+
+/**
+ * @param sw The #Mode pointer
+ *
+ * Get the strings the entries are matched on. Only valid when matching an entry
+ * is the same as matching its string in the table with #helper_string_table_token_match.
+ * The table has to stay valid until the entries of the mode change.
+ *
+ * @returns the string table, or NULL if not available.
+ */
+typedef const RofiStringTable * ( *_mode_get_string_table )( const Mode *sw );
+
 /**
  * @param sw The #Mode pointer
  *
@@ -170,12 +219,20 @@ struct rofi_mode
     _mode_result            _result;
     /** Token match. */
     _mode_token_match       _token_match;
+    /** Token match on a range of rows. */
+    _mode_token_match_batch _token_match_batch;
+    /** Rows that can match, narrowed down by an index. */
+    _mode_token_candidates  _token_candidates;
+    /** The strings the entries are matched on. */
+    _mode_get_string_table  _get_string_table;
     /** Get the string to display for the entry. */
     _mode_get_display_value _get_display_value;
     /** Get the icon for the entry. */
     _mode_get_icon          _get_icon;
     /** Get the 'completed' entry. */
     _mode_get_completion    _get_completion;
+    /** Get the 'completed' entry without copying it. */
+    _mode_peek_completion   _peek_completion;
 
     _mode_preprocess_input  _preprocess_input;
 
@@ -148,6 +148,19 @@ cairo_surface_t * mode_get_icon ( const Mode *mode, unsigned int selected_line,
  */
 char * mode_get_completion ( const Mode *mode, unsigned int selected_line );
 
+/**
+ * @param mode The mode to query
+ * @param selected_line The entry to query
+ * @param length Set to the length of the returned string in characters [out]
+ *
+ * Return the string used for completion without copying it, if the mode supports this.
+ * Used to score rows while filtering, so this does no allocation.
+ *
+ * @returns the completion string owned by the mode (only length characters are valid, it does
+ * not need to be terminated), or NULL if not available.
+ */
+const char * mode_peek_completion ( const Mode *mode, unsigned int selected_line, glong *length );
+
 /**
  * @param mode The mode to query
  * @param menu_retv The menu return value.
@@ -171,6 +184,39 @@ ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int sel
  */
 int mode_token_match ( const Mode *mode, rofi_int_matcher **tokens, unsigned int selected_line );
 
+/**
+ * @param mode The mode to query
+ * @param tokens The set of tokens to match against
+ * @param start The first entry to match
+ * @param stop The entry after the last entry to match
+ * @param out Filled with the matching entries, room for stop - start entries [out]
+ * @param count Set to the number of matching entries [out]
+ *
+ * Match the entries in [start, stop) against the set of tokens.
+ */
+void mode_token_match_batch ( const Mode *mode, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count );
+
+/**
+ * @param mode The mode to query
+ * @param tokens The set of tokens to match against
+ * @param length Set to the number of candidates [out]
+ *
+ * Ask the mode which rows can match the tokens, if it keeps an index.
+ *
+ * @returns a sorted array of candidate rows (free with g_free), or NULL if all rows have to be matched.
+ */
+unsigned int * mode_token_candidates ( const Mode *mode, rofi_int_matcher **tokens, unsigned int *length );
+
+/**
+ * @param mode The mode to query
+ *
+ * Get the table with the strings the entries of the mode are matched on, so they
+ * can be matched without calling into the mode.
+ *
+ * @returns the string table, or NULL if the mode does not provide one.
+ */
+const RofiStringTable * mode_get_string_table ( const Mode *mode );
+
 /**
  * @param mode The mode to query
  *
@@ -329,10 +329,46 @@ typedef struct rofi_range_pair
  */
 typedef struct rofi_int_matcher_t
 {
+    /** Compiled regex, only set for regex and glob matching. */
     GRegex   *regex;
+    /** Invert the match. */
     gboolean invert;
+
+    /** Matching method used when there is no regex. */
+    int      method;
+    /** Case sensitive match. */
+    gboolean case_sensitive;
+    /** The pattern to match (UTF-8), case folded when matching case insensitive. */
+    char     *pattern;
+    /** Length of pattern in bytes. */
+    size_t   pattern_len;
+    /** The pattern as characters, lower case when matching case insensitive. */
+    gunichar *chars;
+    /** Number of characters in the pattern. */
+    glong    num_chars;
+    /** Number of references, matchers are shared between token arrays by the matcher cache. */
+    gint     refcount;
 } rofi_int_matcher;
 
+/**
+ * Read-only table referring to the string each entry of a mode is matched on.
+ * Modes export it, so the view can match the entries without calling into the
+ * mode for each of them.
+ */
+typedef struct rofi_string_table
+{
+    /** The string of each entry, NULL for an entry without string. Only lengths bytes are read, it does not need to be terminated. */
+    const char   **strings;
+    /** Length of the string of each entry in bytes. */
+    unsigned int *lengths;
+    /** Number of entries. */
+    unsigned int length;
+    /** The strings are normalized. */
+    gboolean     normalize;
+    /** The strings are case folded. */
+    gboolean     folded;
+} RofiStringTable;
+
 /**
  * Structure with data to process by each worker thread.
  * TODO: Make this more generic wrapper.
@@ -104,6 +104,8 @@ typedef struct
     SortingMethod  sorting_method_enum;
     /** Sorting method. */
     char           * sorting_method;
+    /** Maximum number of characters scored by the fzf sorting method (0 for no limit). */
+    unsigned int   sorting_max_length;
 
     /** Desktop entries to match in drun */
     char           * drun_match_fields;
@@ -78,6 +78,8 @@ struct RofiViewState
 
     /** number of (filtered) elements to show. */
     unsigned int     filtered_lines;
+    /** number of (filtered) elements at the start of line_map that are sorted. */
+    unsigned int     sorted_lines;
 
     /** Previously called key action. */
     KeyBindingAction prev_action;
@@ -138,6 +140,44 @@ struct RofiViewState
 
     /** Regexs used for matching */
     rofi_int_matcher **tokens;
+
+    /** State of the previous filter run, used to narrow down the result on extended input. */
+    struct
+    {
+        /** The user input. (NULL when the previous run did not filter) */
+        char         *text;
+        /** The preprocessed user input. */
+        char         *pattern;
+        /** Matching method used. */
+        unsigned int matching_method;
+        /** Case sensitivity used. */
+        unsigned int case_sensitive;
+        /** Tokenize setting used. */
+        unsigned int tokenize;
+        /** Normalize setting used. */
+        unsigned int normalize_match;
+        /** Sort setting used. */
+        unsigned int sort;
+    }                last_filter;
+
+    /** Filter run in progress. (NULL when the result is complete) */
+    struct _filter_job *filter_job;
+    /** Idle source continuing the filter run. */
+    guint              filter_source;
+    /** Generation of the last started filter run. */
+    guint              filter_generation;
+    /** Number of rows to filter in one step of the main loop. */
+    unsigned int       filter_step;
+    /** Results of recent filter runs, most recently used first. */
+    GQueue             filter_cache;
+    /** Number of rows in all cached results together. */
+    unsigned int       filter_cache_rows;
+    /** Highlighted ranges of the drawn rows, by entry. */
+    GHashTable         *highlight_cache;
+    /** Rows up to this one were added by the mode, but not yet filtered. */
+    unsigned int       rows_added_stop;
+    /** Source filtering the added rows. */
+    guint              rows_added_source;
 };
 /** @} */
 #endif
@@ -250,6 +250,31 @@ void rofi_view_hide ( void );
  */
 void rofi_view_reload ( void  );
 
+/**
+ * @param start The first added row
+ * @param stop The row after the last added row
+ *
+ * Indicate the mode of the current view appended rows [start, stop), the other rows
+ * did not change. Only the new rows are filtered and added to the result, so a mode can
+ * show entries while it is still loading them.
+ *
+ * Like #rofi_view_reload this happens 'lazy', multiple calls might be handled at once.
+ */
+void rofi_view_rows_added ( unsigned int start, unsigned int stop );
+
+/**
+ * @param sw The mode to filter
+ * @param input The user input to filter on
+ * @param length Set to the number of matching entries [out]
+ *
+ * Filter the entries of the mode without a view, like the view does for its
+ * input: matching on the worker threads and, with sorting enabled, ranking the
+ * matches. Needs #rofi_view_workers_initialize, but no display.
+ *
+ * @returns the matching entries in display order, free with g_free.
+ */
+unsigned int *rofi_view_filter_rows ( Mode *sw, const char *input, unsigned int *length );
+
 /**
  * @param state The handle to the view
  * @param mode The new mode to display
@@ -200,6 +200,29 @@ static int combi_mode_match ( const Mode *sw, rofi_int_matcher **tokens, unsigne
     }
     return 0;
 }
+static void combi_mode_match_batch ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count )
+{
+    CombiModePrivateData *pd      = mode_get_private_data ( sw );
+    unsigned int         matched = 0;
+    // Hand each mode the part of the range it holds.
+    for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
+        if ( pd->switchers[i].disable ) {
+            continue;
+        }
+        unsigned int s = MAX ( start, pd->starts[i] );
+        unsigned int e = MIN ( stop, pd->starts[i] + pd->lengths[i] );
+        if ( s >= e ) {
+            continue;
+        }
+        unsigned int n = 0;
+        mode_token_match_batch ( pd->switchers[i].mode, tokens, s - pd->starts[i], e - pd->starts[i], &( out[matched] ), &n );
+        for ( unsigned int j = 0; j < n; j++ ) {
+            out[matched + j] += pd->starts[i];
+        }
+        matched += n;
+    }
+    *count = matched;
+}
 static char * combi_mgrv ( const Mode *sw, unsigned int selected_line, int *state, GList **attr_list, int get_entry )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
@@ -257,6 +280,18 @@ static char * combi_get_completion ( const Mode *sw, unsigned int index )
     return NULL;
 }
 
+static const char * combi_peek_completion ( const Mode *sw, unsigned int index, glong *length )
+{
+    CombiModePrivateData *pd = mode_get_private_data ( sw );
+    for ( unsigned i = 0; i < pd->num_switchers; i++ ) {
+        if ( index >= pd->starts[i] && index < ( pd->starts[i] + pd->lengths[i] ) ) {
+            // Scored without the '!mode' prefix, it is the same for all rows of a mode.
+            return mode_peek_completion ( pd->switchers[i].mode, index - pd->starts[i], length );
+        }
+    }
+    return NULL;
+}
+
 static cairo_surface_t * combi_get_icon ( const Mode *sw, unsigned int index, int height )
 {
     CombiModePrivateData *pd = mode_get_private_data ( sw );
@@ -310,7 +345,9 @@ Mode combi_mode =
     ._result            = combi_mode_result,
     ._destroy           = combi_mode_destroy,
     ._token_match       = combi_mode_match,
+    ._token_match_batch = combi_mode_match_batch,
     ._get_completion    = combi_get_completion,
+    ._peek_completion   = combi_peek_completion,
     ._get_display_value = combi_mgrv,
     ._get_icon          = combi_get_icon,
     ._preprocess_input  = combi_preprocess_input,
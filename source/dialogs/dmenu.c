@@ -50,11 +50,14 @@
 #include "xrmoptions.h"
 #include "view.h"
 #include "rofi-icon-fetcher.h"
+#include "timings.h"
 
 #include "dialogs/dmenuscriptshared.h"
 
 static int dmenu_mode_init ( Mode *sw );
 static int dmenu_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index );
+static void dmenu_token_match_batch ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count );
+static const RofiStringTable *dmenu_get_string_table ( const Mode *sw );
 static cairo_surface_t *dmenu_get_icon ( const Mode *sw, unsigned int selected_line, int height );
 static char *dmenu_get_message ( const Mode *sw );
 
@@ -72,6 +75,11 @@ static inline void bittoggle ( uint32_t *array, unsigned int index )
     *v ^= 1 << bit;
 }
 
+/** Number of bytes read from the input in one asynchronous read. */
+#define DMENU_READ_CHUNK_SIZE     65536
+/** Number of bytes read from the input in one block when reading synchronously. */
+#define DMENU_PARSE_BLOCK_SIZE    ( 1024 * 1024 )
+
 typedef struct
 {
     /** Settings */
@@ -90,93 +98,759 @@ typedef struct
     unsigned int           do_markup;
     // List with entries.
     DmenuScriptEntry       *cmd_list;
+    /** The text the entries are matched on, when markup or column matching is enabled. (NULL if invalid) */
+    char                   **match_text;
     unsigned int           cmd_list_real_length;
     unsigned int           cmd_list_length;
+    /** Strings of the entries. */
+    GStringChunk           *strings;
+    /** The entries in the form they are matched. */
+    RofiMatchCache         *match_cache;
+    /** One of the entries has meta data, this is matched besides the entry. */
+    gboolean               has_meta;
+    /** Trigram index over the entries, built in the background for large inputs. */
+    RofiTrigramIndex       *index;
+    /** Thread building the index. */
+    GThread                *index_thread;
+    /** Set to abort building the index. */
+    gint                   index_cancel;
+    /** Minimum number of entries to build the index for (0 to disable). */
+    unsigned int           index_threshold;
     unsigned int           only_selected;
     unsigned int           selected_count;
 
-    gchar                  **columns;
-    gchar                  *column_separator;
+    /** Columns to display, counted from 1. (NULL to display the whole entry) */
+    unsigned int           *columns;
+    /** Number of columns to display. */
+    unsigned int           num_columns;
+    /** Highest column to display. */
+    unsigned int           max_column;
+    /** Separator between the columns. */
+    GRegex                 *column_regex;
+    /** For each entry, the start and length of each displayed column. (start is G_MAXUINT32 if missing) */
+    guint32                *column_spans;
+    /** Match the displayed columns only. */
+    gboolean               match_columns;
     gboolean               multi_select;
 
     GCancellable           *cancel;
     gulong                 cancel_source;
     GInputStream           *input_stream;
     GDataInputStream       *data_input_stream;
+    /** Buffer the asynchronous reads read into. */
+    char                   *read_buffer;
+    /** Start of the line not completed by the chunks read so far. */
+    GString                *read_pending;
+    /** Mapped input file (read-only), entries point into it. (NULL when reading from a stream) */
+    GMappedFile            *mapped;
+    /** Blocks parsed while reading synchronously, entries point into them. */
+    GPtrArray              *blocks;
+
+    /** Keep the rows compact, as offsets into a single store instead of entries. */
+    gboolean               compact;
+    /** Compact: offset of each row in the store. */
+    guint32                *row_offsets;
+    /** Compact: the mapped input, the start of the store. (NULL when reading from a stream) */
+    const char             *store_input;
+    /** Compact: length of the mapped input, offsets past it point into the appended rows. */
+    gsize                  store_base;
+    /** Compact: the appended rows, each terminated by a '\0'. */
+    char                   *store;
+    gsize                  store_length;
+    gsize                  store_size;
+    /** Compact: set once the store ran out of offsets. */
+    gboolean               store_full;
+    /** Compact: the extras of the rows that have them, by row. */
+    GHashTable             *row_extras;
 } DmenuModePrivateData;
 
+/**
+ * A block of input parsed by a worker while reading synchronously.
+ */
+typedef struct
+{
+    /** Generic thread state. */
+    thread_state               st;
+    /** The dmenu mode data, only the settings are read by the worker. */
+    const DmenuModePrivateData *pd;
+    /** The lines, valid lines are used in place. */
+    char                       *data;
+    /** Length of data. */
+    gsize                      length;
+    /** Strings of the entries that could not be used in place. */
+    GStringChunk               *strings;
+    /** The parsed entries. */
+    DmenuScriptEntry           *entries;
+    /** The text the entries are matched on, when it differs from the entries. */
+    char                       **match_text;
+    /** The displayed columns of the entries, when columns are selected. */
+    guint32                    *column_spans;
+    /** Number of parsed entries. */
+    unsigned int               num_entries;
+    /** Signalled when a block is done, shared by the blocks. */
+    GCond                      *cond;
+    /** Protects done, shared by the blocks. */
+    GMutex                     *mutex;
+    /** Set when the worker is done. */
+    gboolean                   done;
+} DmenuParseBlock;
+
 static void async_close_callback ( GObject *source_object, GAsyncResult *res, G_GNUC_UNUSED gpointer user_data )
 {
     g_input_stream_close_finish ( G_INPUT_STREAM ( source_object ), res, NULL );
     g_debug ( "Closing data stream." );
 }
 
-static void read_add ( DmenuModePrivateData * pd, char *data, gsize len )
+/**
+ * @param pd The dmenu mode data
+ *
+ * @returns TRUE if the entries are matched on a text different from the entry.
+ */
+static inline gboolean dmenu_has_match_text ( const DmenuModePrivateData *pd )
+{
+    return pd->do_markup || pd->match_columns;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param index The entry
+ * @param length Set to the length of the content in bytes [out]
+ *
+ * @returns the content of the entry, this is not terminated when it is used in place.
+ */
+static inline const char *dmenu_row_text ( const DmenuModePrivateData *pd, unsigned int index, gsize *length )
+{
+    if ( !pd->compact ) {
+        *length = pd->cmd_list[index].entry_size;
+        return pd->cmd_list[index].entry;
+    }
+    guint32 offset = pd->row_offsets[index];
+    if ( offset < pd->store_base ) {
+        // Ends on the separator, the start of the extras or the end of the input.
+        const char *text = pd->store_input + offset;
+        const char *end  = pd->store_input + pd->store_base;
+        const char *iter = text;
+        while ( iter < end && iter[0] != pd->separator && iter[0] != '\0' ) {
+            iter++;
+        }
+        *length = iter - text;
+        return text;
+    }
+    const char *text = pd->store + ( offset - pd->store_base );
+    *length = strlen ( text );
+    return text;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param index The entry
+ *
+ * @returns the extras (icon, meta, info) of the entry, or NULL if it has none.
+ */
+static inline DmenuScriptEntry *dmenu_row_extras ( const DmenuModePrivateData *pd, unsigned int index )
+{
+    if ( !pd->compact ) {
+        return &( pd->cmd_list[index] );
+    }
+    if ( pd->row_extras == NULL ) {
+        return NULL;
+    }
+    return (DmenuScriptEntry *) g_hash_table_lookup ( pd->row_extras, GUINT_TO_POINTER ( index ) );
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param index The entry
+ *
+ * @returns TRUE if the entry can not be selected.
+ */
+static inline gboolean dmenu_row_nonselectable ( const DmenuModePrivateData *pd, unsigned int index )
+{
+    const DmenuScriptEntry *extras = dmenu_row_extras ( pd, index );
+    return extras != NULL && extras->nonselectable;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param index The entry
+ * @param length Set to the length of the text in bytes, or -1 if the text is terminated [out]
+ *
+ * @returns the text the entry is matched and scored on, the displayed columns with the markup stripped.
+ */
+static inline const char *dmenu_entry_match_text ( const DmenuModePrivateData *pd, unsigned int index, gssize *length )
+{
+    if ( dmenu_has_match_text ( pd ) ) {
+        *length = -1;
+        return pd->match_text[index];
+    }
+    gsize      len   = 0;
+    const char *text = dmenu_row_text ( pd, index, &len );
+    *length = len;
+    return text;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param size The new size of the list.
+ *
+ * Resize the list of entries, and the side tables along with it.
+ */
+static void dmenu_list_resize ( DmenuModePrivateData *pd, unsigned int size )
+{
+    pd->cmd_list_real_length = size;
+    if ( pd->compact ) {
+        pd->row_offsets = g_realloc_n ( pd->row_offsets, pd->cmd_list_real_length, sizeof ( guint32 ) );
+    }
+    else {
+        pd->cmd_list = g_realloc ( pd->cmd_list, ( pd->cmd_list_real_length ) * sizeof ( DmenuScriptEntry ) );
+    }
+    if ( dmenu_has_match_text ( pd ) ) {
+        pd->match_text = g_realloc ( pd->match_text, ( pd->cmd_list_real_length ) * sizeof ( char * ) );
+    }
+    if ( pd->columns != NULL ) {
+        pd->column_spans = g_realloc_n ( pd->column_spans, pd->cmd_list_real_length, 2 * pd->num_columns * sizeof ( guint32 ) );
+    }
+}
+
+static const char *dmenu_index_get_string ( gpointer data, unsigned int index, unsigned int field, gsize *length )
+{
+    DmenuModePrivateData *pd = (DmenuModePrivateData *) data;
+    // Rows that do not match on the entry are matched on the meta data.
+    switch ( field )
+    {
+    case 0:
+    {
+        gssize     len   = 0;
+        const char *text = dmenu_entry_match_text ( pd, index, &len );
+        if ( text != NULL ) {
+            *length = ( len < 0 ) ? strlen ( text ) : (gsize) len;
+        }
+        return text;
+    }
+    case 1:
+    {
+        const DmenuScriptEntry *extras = dmenu_row_extras ( pd, index );
+        if ( extras == NULL || extras->meta == NULL ) {
+            return NULL;
+        }
+        *length = strlen ( extras->meta );
+        return extras->meta;
+    }
+    default:
+        return NULL;
+    }
+}
+
+static gpointer dmenu_index_build ( gpointer data )
+{
+    DmenuModePrivateData *pd    = (DmenuModePrivateData *) data;
+    RofiTrigramIndex     *index = helper_trigram_index_new ( pd->cmd_list_length, dmenu_index_get_string, pd, &( pd->index_cancel ) );
+    if ( index != NULL ) {
+        g_debug ( "Built trigram index over %u entries.", pd->cmd_list_length );
+    }
+    g_atomic_pointer_set ( &( pd->index ), index );
+    return NULL;
+}
+
+/**
+ * @param pd The dmenu mode data
+ *
+ * Start building the index in the background once all entries are read, the list
+ * does not change from then on.
+ */
+static void dmenu_index_start ( DmenuModePrivateData *pd )
+{
+    // Compact rows are kept small, the index would be larger than the rows.
+    if ( pd->compact || pd->index_threshold == 0 || pd->cmd_list_length < pd->index_threshold || pd->index_thread != NULL ) {
+        return;
+    }
+    pd->index_thread = g_thread_new ( "dmenu-index", dmenu_index_build, pd );
+}
+
+/**
+ * @param strings The string chunk to store the extras in.
+ * @param entry The entry to initialize.
+ * @param data The line, it is not modified.
+ * @param len The length of the line.
+ *
+ * Initialize the entry and parse the extras following the visible part.
+ * This does not touch the mode data, it is called from the workers too.
+ *
+ * @returns the length of the visible part of the line.
+ */
+static gsize dmenu_entry_parse_extras ( GStringChunk *strings, DmenuScriptEntry *entry, const char *data, gsize len )
+{
+    entry->icon_fetch_uid = 0;
+    entry->icon_name      = NULL;
+    entry->meta           = NULL;
+    entry->info           = NULL;
+    entry->nonselectable  = FALSE;
+    const char *end = memchr ( data, '\0', len );
+    if ( end == NULL ) {
+        return len;
+    }
+    dmenuscript_parse_entry_extras ( NULL, strings, entry, end + 1, len - ( end - data ) - 1 );
+    return end - data;
+}
+
+/**
+ * @param strings The string chunk to store the copy in.
+ * @param data The content of the entry.
+ * @param len The length of data, set to the length of the copy.
+ *
+ * Copy the content into the string chunk, invalid UTF-8 is replaced.
+ *
+ * @returns the copy, owned by the string chunk.
+ */
+static char *dmenu_insert_utf8 ( GStringChunk *strings, const char *data, gsize *len )
+{
+    if ( g_utf8_validate ( data, *len, NULL ) ) {
+        return g_string_chunk_insert_len ( strings, data, *len );
+    }
+    char *utfstr = rofi_force_utf8 ( data, *len );
+    *len = strlen ( utfstr );
+    char *retv = g_string_chunk_insert_len ( strings, utfstr, *len );
+    g_free ( utfstr );
+    return retv;
+}
+
+/**
+ * @param strings The string chunk to store the stripped text in.
+ * @param str The entry content.
+ * @param len The length of str, or -1 if str is terminated.
+ *
+ * @returns the content with the markup stripped, or NULL if the markup is invalid.
+ */
+static char *dmenu_strip_markup ( GStringChunk *strings, const char *str, gssize len )
+{
+    char *esc = NULL;
+    pango_parse_markup ( str, len, 0, NULL, &esc, NULL, NULL );
+    char *retv = ( esc != NULL ) ? g_string_chunk_insert ( strings, esc ) : NULL;
+    g_free ( esc );
+    return retv;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param spans The columns of the entry.
+ * @param pieces The number of pieces found so far.
+ * @param pending Start and length of the last piece found.
+ * @param start The start of the new piece.
+ * @param length The length of the new piece.
+ *
+ * Add the next piece of the split entry. A piece is only displayed when another piece
+ * follows it, so this sets the column of the pending piece and keeps the new one pending.
+ */
+static void dmenu_columns_add_piece ( const DmenuModePrivateData *pd, guint32 *spans, unsigned int *pieces, gint *pending, gint start, gint length )
+{
+    for ( unsigned int i = 0; *pieces > 0 && i < pd->num_columns; i++ ) {
+        if ( pd->columns[i] == *pieces ) {
+            spans[2 * i]     = pending[0];
+            spans[2 * i + 1] = pending[1];
+        }
+    }
+    ( *pieces )++;
+    pending[0] = start;
+    pending[1] = length;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param str The entry content.
+ * @param len The length of str.
+ * @param spans Set to the start and length of each displayed column.
+ *
+ * Split the entry into columns the way g_regex_split() does: an empty match right after
+ * the previous separator does not split, captured groups are pieces of their own, and
+ * nothing follows a trailing empty match. Like before, the last piece is not a column.
+ * The search position is tracked like g_match_info_next() does, so separators with
+ * lookaround give the same columns as the split did.
+ * This does not change the mode data, it is called from the workers too.
+ */
+static void dmenu_columns_split ( const DmenuModePrivateData *pd, const char *str, gsize len, guint32 *spans )
+{
+    for ( unsigned int i = 0; i < pd->num_columns; i++ ) {
+        spans[2 * i]     = G_MAXUINT32;
+        spans[2 * i + 1] = 0;
+    }
+    if ( pd->column_regex == NULL ) {
+        return;
+    }
+    GMatchInfo   *info      = NULL;
+    unsigned int pieces     = 0;
+    gint         pending[2] = { 0, 0 };
+    gint         last_end   = 0;
+    gint         search     = 0;
+    gboolean     last_empty = FALSE;
+    g_regex_match_full ( pd->column_regex, str, len, 0, 0, &info, NULL );
+    while ( pieces <= pd->max_column && g_match_info_matches ( info ) ) {
+        gint match_start = 0, match_end = 0;
+        g_match_info_fetch_pos ( info, 0, &match_start, &match_end );
+        last_empty = ( match_start == match_end );
+        if ( match_end != last_end ) {
+            dmenu_columns_add_piece ( pd, spans, &pieces, pending, last_end, match_start - last_end );
+            gint groups = g_match_info_get_match_count ( info );
+            for ( gint group = 1; group < groups; group++ ) {
+                gint group_start = 0, group_end = 0;
+                // A group that did not take part in the match is an empty piece.
+                if ( !g_match_info_fetch_pos ( info, group, &group_start, &group_end ) || group_start < 0 ) {
+                    group_start = group_end = 0;
+                }
+                dmenu_columns_add_piece ( pd, spans, &pieces, pending, group_start, group_end - group_start );
+            }
+        }
+        if ( !last_empty ) {
+            last_end = match_end;
+            search   = match_end;
+        }
+        else {
+            // After an empty match found past where the search started, g_regex_split()
+            // starts the next piece one character before the match.
+            last_end = ( search == match_end ) ? match_end : ( g_utf8_prev_char ( str + match_end ) - str );
+            search   = ( match_end < (gint) len ) ? ( g_utf8_next_char ( str + match_end ) - str ) : ( match_end + 1 );
+        }
+        g_match_info_next ( info, NULL );
+    }
+    if ( pieces <= pd->max_column && !last_empty ) {
+        dmenu_columns_add_piece ( pd, spans, &pieces, pending, last_end, len - last_end );
+    }
+    g_match_info_free ( info );
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param str The entry content.
+ * @param spans The columns of the entry, from dmenu_columns_split().
+ *
+ * @returns a newly allocated string with the displayed columns, separated by a tab.
+ */
+static char *dmenu_columns_join ( const DmenuModePrivateData *pd, const char *str, const guint32 *spans )
+{
+    GString  *retv = g_string_sized_new ( 64 );
+    gboolean first = TRUE;
+    for ( unsigned int i = 0; i < pd->num_columns; i++ ) {
+        if ( spans[2 * i] == G_MAXUINT32 ) {
+            continue;
+        }
+        if ( !first ) {
+            g_string_append_c ( retv, '\t' );
+        }
+        g_string_append_len ( retv, str + spans[2 * i], spans[2 * i + 1] );
+        first = FALSE;
+    }
+    return g_string_free ( retv, FALSE );
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param strings The string chunk to store the text in.
+ * @param str The entry content.
+ * @param len The length of str.
+ * @param spans The columns of the entry, or NULL if no columns are selected.
+ *
+ * @returns the text the entry is matched on, or NULL if the markup is invalid.
+ */
+static char *dmenu_match_text_new ( const DmenuModePrivateData *pd, GStringChunk *strings, const char *str, gsize len, const guint32 *spans )
+{
+    char *joined = NULL;
+    if ( pd->match_columns && spans != NULL ) {
+        str = joined = dmenu_columns_join ( pd, str, spans );
+        len = strlen ( joined );
+    }
+    char *retv = pd->do_markup ? dmenu_strip_markup ( strings, str, len ) : g_string_chunk_insert_len ( strings, str, len );
+    g_free ( joined );
+    return retv;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param data The line.
+ * @param len The length of the line.
+ * @param data_len Set to the length of the visible part of the line.
+ *
+ * Append a new entry and parse the extras following the visible part.
+ *
+ * @returns the new entry, its content still needs to be set.
+ */
+static DmenuScriptEntry *read_add_extras ( DmenuModePrivateData * pd, const char *data, gsize len, gsize *data_len )
 {
-    gsize data_len = len;
     if ( ( pd->cmd_list_length + 2 ) > pd->cmd_list_real_length ) {
-        pd->cmd_list_real_length = MAX ( pd->cmd_list_real_length * 2, 512 );
-        pd->cmd_list             = g_realloc ( pd->cmd_list, ( pd->cmd_list_real_length ) * sizeof ( DmenuScriptEntry ) );
-    }
-    // Init.
-    pd->cmd_list[pd->cmd_list_length].icon_fetch_uid = 0;
-    pd->cmd_list[pd->cmd_list_length].icon_name      = NULL;
-    pd->cmd_list[pd->cmd_list_length].meta           = NULL;
-    pd->cmd_list[pd->cmd_list_length].info           = NULL;
-    char *end = data;
-    while ( end < data + len && *end != '\0' ) {
-        end++;
-    }
-    if ( end != data + len ) {
-        data_len = end - data;
-        dmenuscript_parse_entry_extras ( NULL, &( pd->cmd_list[pd->cmd_list_length] ), end + 1, len - data_len );
-    }
-    char *utfstr = rofi_force_utf8 ( data, data_len );
-    pd->cmd_list[pd->cmd_list_length].entry     = utfstr;
+        dmenu_list_resize ( pd, MAX ( pd->cmd_list_real_length * 2, 512 ) );
+    }
+    DmenuScriptEntry *entry = &( pd->cmd_list[pd->cmd_list_length] );
+    *data_len     = dmenu_entry_parse_extras ( pd->strings, entry, data, len );
+    pd->has_meta |= ( entry->meta != NULL );
+    return entry;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param entry The entry returned by read_add_extras()
+ * @param str The valid UTF-8 content of the entry, it does not need to be terminated.
+ * @param len The length of str.
+ *
+ * Finish the entry appended by read_add_extras().
+ * The columns are split and the markup is stripped once here instead of on every draw or match.
+ */
+static void read_add_finish ( DmenuModePrivateData * pd, DmenuScriptEntry *entry, char *str, gsize len )
+{
+    entry->entry                                = str;
+    entry->entry_length                         = g_utf8_strlen ( str, len );
+    entry->entry_size                           = len;
     pd->cmd_list[pd->cmd_list_length + 1].entry = NULL;
+    guint32 *spans = NULL;
+    if ( pd->columns != NULL ) {
+        spans = &( pd->column_spans[pd->cmd_list_length * 2 * pd->num_columns] );
+        dmenu_columns_split ( pd, str, len, spans );
+    }
+    if ( dmenu_has_match_text ( pd ) ) {
+        pd->match_text[pd->cmd_list_length] = dmenu_match_text_new ( pd, pd->strings, str, len, spans );
+    }
+    gssize     match_len   = 0;
+    const char *match_text = dmenu_entry_match_text ( pd, pd->cmd_list_length, &match_len );
+    helper_match_cache_add ( pd->match_cache, match_text, match_len );
 
     pd->cmd_list_length++;
 }
-static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data )
+
+/**
+ * @param pd The dmenu mode data
+ * @param str The row content.
+ * @param len The length of str.
+ *
+ * Append the row to the store. Large blocks are grown in place by the allocator, and the
+ * unused end of the store is not touched, so it does not count towards the used memory.
+ *
+ * @returns the offset of the row, or G_MAXUINT32 if the offsets ran out.
+ */
+static guint32 dmenu_store_append ( DmenuModePrivateData *pd, const char *str, gsize len )
 {
-    GDataInputStream     *stream = (GDataInputStream *) source_object;
-    DmenuModePrivateData *pd     = (DmenuModePrivateData *) user_data;
-    gsize                len;
-    char                 *data = g_data_input_stream_read_upto_finish ( stream, res, &len, NULL );
-    if ( data != NULL ) {
-        // Absorb separator, already in buffer so should not block.
-        g_data_input_stream_read_byte ( stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
-        rofi_view_reload ();
+    gsize offset = pd->store_base + pd->store_length;
+    if ( ( offset + len + 1 ) >= G_MAXUINT32 ) {
+        return G_MAXUINT32;
+    }
+    if ( ( pd->store_length + len + 1 ) > pd->store_size ) {
+        pd->store_size = MAX ( MAX ( pd->store_size * 2, pd->store_length + len + 1 ), DMENU_READ_CHUNK_SIZE );
+        pd->store      = g_realloc ( pd->store, pd->store_size );
+    }
+    memcpy ( pd->store + pd->store_length, str, len );
+    pd->store[pd->store_length + len] = '\0';
+    pd->store_length                 += len + 1;
+    return offset;
+}
 
-        g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                              async_read_callback, pd );
-        return;
+/**
+ * @param pd The dmenu mode data
+ * @param data The line.
+ * @param len The length of the line.
+ * @param valid If the line is known to be valid UTF-8.
+ *
+ * Add the line as compact row. Valid lines in the mapped input are used in place, others
+ * are appended to the store. Only the rows with extras get an entry in the side table.
+ */
+static void read_add_compact ( DmenuModePrivateData * pd, const char *data, gsize len, gboolean valid )
+{
+    DmenuScriptEntry extras;
+    gsize            data_len = dmenu_entry_parse_extras ( pd->strings, &extras, data, len );
+    guint32          offset   = G_MAXUINT32;
+    if ( valid || g_utf8_validate ( data, data_len, NULL ) ) {
+        if ( pd->store_input != NULL && data >= pd->store_input && data < ( pd->store_input + pd->store_base ) ) {
+            // Ends on the separator, the start of the extras or the end of the input.
+            offset = data - pd->store_input;
+        }
+        else {
+            offset = dmenu_store_append ( pd, data, data_len );
+        }
     }
     else {
-        GError *error = NULL;
-        // Absorb separator, already in buffer so should not block.
-        // If error == NULL end of stream..
-        g_data_input_stream_read_byte ( stream, NULL, &error );
-        if (  error == NULL ) {
-            // Add empty line.
-            read_add ( pd, "", 0 );
-            rofi_view_reload ();
-
-            g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                                  async_read_callback, pd );
+        char *utfstr = rofi_force_utf8 ( data, data_len );
+        offset = dmenu_store_append ( pd, utfstr, strlen ( utfstr ) );
+        g_free ( utfstr );
+    }
+    if ( offset == G_MAXUINT32 ) {
+        if ( !pd->store_full ) {
+            g_warning ( "Input does not fit in the compact store, dropping the remaining rows." );
+            pd->store_full = TRUE;
+        }
+        return;
+    }
+    if ( ( pd->cmd_list_length + 2 ) > pd->cmd_list_real_length ) {
+        dmenu_list_resize ( pd, MAX ( pd->cmd_list_real_length * 2, 512 ) );
+    }
+    pd->row_offsets[pd->cmd_list_length] = offset;
+    if ( extras.icon_name != NULL || extras.meta != NULL || extras.info != NULL || extras.nonselectable ) {
+        if ( pd->row_extras == NULL ) {
+            pd->row_extras = g_hash_table_new_full ( g_direct_hash, g_direct_equal, NULL, g_free );
+        }
+        extras.entry        = NULL;
+        extras.entry_length = 0;
+        extras.entry_size   = 0;
+        g_hash_table_insert ( pd->row_extras, GUINT_TO_POINTER ( pd->cmd_list_length ), g_memdup ( &extras, sizeof ( DmenuScriptEntry ) ) );
+        pd->has_meta |= ( extras.meta != NULL );
+    }
+    gsize      str_len = 0;
+    const char *str    = dmenu_row_text ( pd, pd->cmd_list_length, &str_len );
+    guint32    *spans  = NULL;
+    if ( pd->columns != NULL ) {
+        spans = &( pd->column_spans[pd->cmd_list_length * 2 * pd->num_columns] );
+        dmenu_columns_split ( pd, str, str_len, spans );
+    }
+    if ( dmenu_has_match_text ( pd ) ) {
+        pd->match_text[pd->cmd_list_length] = dmenu_match_text_new ( pd, pd->strings, str, str_len, spans );
+    }
+    pd->cmd_list_length++;
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param data The line.
+ * @param len The length of the line.
+ * @param valid If the line is known to be valid UTF-8.
+ *
+ * Add the line as new entry, the content is copied.
+ */
+static void read_add_line ( DmenuModePrivateData * pd, const char *data, gsize len, gboolean valid )
+{
+    if ( pd->compact ) {
+        read_add_compact ( pd, data, len, valid );
+        return;
+    }
+    gsize            data_len = 0;
+    DmenuScriptEntry *entry   = read_add_extras ( pd, data, len, &data_len );
+    char             *str     = valid ? g_string_chunk_insert_len ( pd->strings, data, data_len ) : dmenu_insert_utf8 ( pd->strings, data, &data_len );
+    read_add_finish ( pd, entry, str, data_len );
+}
+
+static void read_add ( DmenuModePrivateData * pd, const char *data, gsize len )
+{
+    read_add_line ( pd, data, len, FALSE );
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param data The chunk read.
+ * @param len The length of the chunk.
+ *
+ * Split the chunk on the separator and add the completed lines. The remainder is kept
+ * until the next chunk completes it.
+ */
+static void read_add_chunk ( DmenuModePrivateData * pd, const char *data, gsize len )
+{
+    const char *end   = data + len;
+    // Validate in bulk, this stops at the first invalid byte or '\0' (start of the extras).
+    const char *valid = data;
+    g_utf8_validate ( data, len, &valid );
+    while ( data < end ) {
+        const char *sep = memchr ( data, pd->separator, end - data );
+        if ( sep == NULL ) {
+            g_string_append_len ( pd->read_pending, data, end - data );
             return;
         }
+        if ( pd->read_pending->len > 0 ) {
+            g_string_append_len ( pd->read_pending, data, sep - data );
+            read_add ( pd, pd->read_pending->str, pd->read_pending->len );
+            g_string_truncate ( pd->read_pending, 0 );
+        }
+        else {
+            read_add_line ( pd, data, sep - data, sep <= valid );
+        }
+        data = sep + 1;
+    }
+}
+
+/**
+ * @param pd The dmenu mode data
+ *
+ * Add all lines from the mapped input file.
+ * The mapping is read-only, valid lines are used in place as slices of the input, so the pages
+ * stay shared with the page cache. Only lines with invalid UTF-8 are copied.
+ */
+static void get_dmenu_mapped ( DmenuModePrivateData *pd )
+{
+    char       *contents = g_mapped_file_get_contents ( pd->mapped );
+    gsize      length    = g_mapped_file_get_length ( pd->mapped );
+    char       *end      = contents + length;
+    // Input up to here is known to be valid UTF-8.
+    const char *valid = contents;
+    if ( pd->compact ) {
+        pd->store_input = contents;
+        pd->store_base  = length;
+    }
+
+    // Size the list up front, it is not grown while adding.
+    unsigned int lines = 0;
+    for ( char *iter = contents; iter < end; lines++ ) {
+        char *sep = memchr ( iter, pd->separator, end - iter );
+        iter = ( sep != NULL ) ? sep + 1 : end;
+    }
+    dmenu_list_resize ( pd, MAX ( pd->cmd_list_length + lines + 2, pd->cmd_list_real_length ) );
+
+    for ( char *data = contents; data < end; ) {
+        char  *sep = memchr ( data, pd->separator, end - data );
+        // The last line does not need to end on a separator.
+        char  *line_end = ( sep != NULL ) ? sep : end;
+        gsize len       = line_end - data;
+        // Validate in bulk, this stops at the first invalid byte or '\0' (start of the extras).
+        if ( valid <= data ) {
+            g_utf8_validate ( data, end - data, &valid );
+        }
+        if ( pd->compact ) {
+            read_add_compact ( pd, data, len, ( data + len ) <= valid );
+            data = line_end + 1;
+            continue;
+        }
+        gsize            data_len = 0;
+        DmenuScriptEntry *entry   = read_add_extras ( pd, data, len, &data_len );
+        if ( ( data + data_len ) <= valid || g_utf8_validate ( data, data_len, NULL ) ) {
+            read_add_finish ( pd, entry, data, data_len );
+        }
         else {
+            char *str = dmenu_insert_utf8 ( pd->strings, data, &data_len );
+            read_add_finish ( pd, entry, str, data_len );
+        }
+        data = line_end + 1;
+    }
+    TICK_N ( "Read mapped input" );
+    dmenu_index_start ( pd );
+}
+static void async_read_callback ( GObject *source_object, GAsyncResult *res, gpointer user_data )
+{
+    GInputStream         *stream = G_INPUT_STREAM ( source_object );
+    DmenuModePrivateData *pd     = (DmenuModePrivateData *) user_data;
+    GError               *error  = NULL;
+    gssize               nread   = g_input_stream_read_finish ( stream, res, &error );
+    if ( nread > 0 ) {
+        // The view is notified once for all rows in the chunk.
+        unsigned int start = pd->cmd_list_length;
+        read_add_chunk ( pd, pd->read_buffer, nread );
+        if ( pd->cmd_list_length > start ) {
+            rofi_view_rows_added ( start, pd->cmd_list_length );
+        }
+
+        g_input_stream_read_async ( stream, pd->read_buffer, DMENU_READ_CHUNK_SIZE, G_PRIORITY_LOW, pd->cancel,
+                                    async_read_callback, pd );
+        return;
+    }
+    if ( error != NULL ) {
+        if ( g_error_matches ( error, G_IO_ERROR, G_IO_ERROR_CANCELLED ) ) {
             g_error_free ( error );
+            return;
         }
+        g_warning ( "Failed to read input: %s", error->message );
+        g_error_free ( error );
     }
     if ( !g_cancellable_is_cancelled ( pd->cancel ) ) {
+        // The last line does not need to end on a separator.
+        if ( pd->read_pending->len > 0 ) {
+            read_add ( pd, pd->read_pending->str, pd->read_pending->len );
+            g_string_truncate ( pd->read_pending, 0 );
+            rofi_view_rows_added ( pd->cmd_list_length - 1, pd->cmd_list_length );
+        }
+        dmenu_index_start ( pd );
         // Hack, don't use get active.
         g_debug ( "Clearing overlay" );
         rofi_view_set_overlay ( rofi_view_get_active (), NULL );
-        g_input_stream_close_async ( G_INPUT_STREAM ( stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+        g_input_stream_close_async ( stream, G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
     }
 }
 
@@ -192,29 +866,243 @@ static int get_dmenu_async ( DmenuModePrivateData *pd, int sync_pre_read )
         char  *data = g_data_input_stream_read_upto ( pd->data_input_stream, &( pd->separator ), 1, &len, NULL, NULL );
         if ( data == NULL ) {
             g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+            dmenu_index_start ( pd );
             return FALSE;
         }
         g_data_input_stream_read_byte ( pd->data_input_stream, NULL, NULL );
         read_add ( pd, data, len );
         g_free ( data );
     }
-    g_data_input_stream_read_upto_async ( pd->data_input_stream, &( pd->separator ), 1, G_PRIORITY_LOW, pd->cancel,
-                                          async_read_callback, pd );
+    // Read the rest in chunks, the data stream hands out its buffered data first.
+    pd->read_buffer  = g_malloc ( DMENU_READ_CHUNK_SIZE );
+    pd->read_pending = g_string_new ( NULL );
+    g_input_stream_read_async ( G_INPUT_STREAM ( pd->data_input_stream ), pd->read_buffer, DMENU_READ_CHUNK_SIZE, G_PRIORITY_LOW, pd->cancel,
+                                async_read_callback, pd );
     return TRUE;
 }
+/**
+ * @param ts The #DmenuParseBlock to parse.
+ * @param user_data Unused.
+ *
+ * Split the block into lines and parse them. Valid lines are used in place, only
+ * lines with invalid UTF-8 and the extras are copied.
+ */
+static void dmenu_parse_block ( thread_state *ts, G_GNUC_UNUSED gpointer user_data )
+{
+    DmenuParseBlock *block = (DmenuParseBlock *) ts;
+    char            *end   = block->data + block->length;
+    unsigned int    lines  = 0;
+    for ( char *iter = block->data; iter < end; lines++ ) {
+        char *sep = memchr ( iter, block->pd->separator, end - iter );
+        iter = ( sep != NULL ) ? sep + 1 : end;
+    }
+    block->strings = g_string_chunk_new ( DMENU_SCRIPT_STRINGS_CHUNK_SIZE );
+    block->entries = g_malloc_n ( lines, sizeof ( DmenuScriptEntry ) );
+    if ( dmenu_has_match_text ( block->pd ) ) {
+        block->match_text = g_malloc_n ( lines, sizeof ( char * ) );
+    }
+    if ( block->pd->columns != NULL ) {
+        block->column_spans = g_malloc_n ( lines, 2 * block->pd->num_columns * sizeof ( guint32 ) );
+    }
+    // Input up to here is known to be valid UTF-8.
+    const char *valid = block->data;
+    for ( char *data = block->data; data < end; ) {
+        char *sep = memchr ( data, block->pd->separator, end - data );
+        // The last line of the input does not need a separator.
+        char *line_end = ( sep != NULL ) ? sep : end;
+        // Validate in bulk, this stops at the first invalid byte or '\0' (start of the extras).
+        if ( valid <= data ) {
+            g_utf8_validate ( data, end - data, &valid );
+        }
+        DmenuScriptEntry *entry   = &( block->entries[block->num_entries] );
+        gsize            data_len = dmenu_entry_parse_extras ( block->strings, entry, data, line_end - data );
+        if ( ( data + data_len ) <= valid ) {
+            entry->entry = data;
+        }
+        else {
+            entry->entry = dmenu_insert_utf8 ( block->strings, data, &data_len );
+        }
+        entry->entry_length = g_utf8_strlen ( entry->entry, data_len );
+        entry->entry_size   = data_len;
+        guint32 *spans = NULL;
+        if ( block->pd->columns != NULL ) {
+            spans = &( block->column_spans[block->num_entries * 2 * block->pd->num_columns] );
+            dmenu_columns_split ( block->pd, entry->entry, data_len, spans );
+        }
+        if ( dmenu_has_match_text ( block->pd ) ) {
+            block->match_text[block->num_entries] = dmenu_match_text_new ( block->pd, block->strings, entry->entry, data_len, spans );
+        }
+        block->num_entries++;
+        data = line_end + 1;
+    }
+    g_mutex_lock ( block->mutex );
+    block->done = TRUE;
+    g_cond_signal ( block->cond );
+    g_mutex_unlock ( block->mutex );
+}
+
+static void dmenu_parse_block_free ( DmenuParseBlock *block )
+{
+    g_free ( block->data );
+    if ( block->strings != NULL ) {
+        g_string_chunk_free ( block->strings );
+    }
+    g_free ( block->entries );
+    g_free ( block->match_text );
+    g_free ( block->column_spans );
+    g_free ( block );
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param block The block to add.
+ *
+ * Wait for the worker to finish the block and append its entries, this keeps the input order.
+ */
+static void dmenu_parse_block_merge ( DmenuModePrivateData *pd, DmenuParseBlock *block )
+{
+    g_mutex_lock ( block->mutex );
+    while ( !block->done ) {
+        g_cond_wait ( block->cond, block->mutex );
+    }
+    g_mutex_unlock ( block->mutex );
+    if ( ( pd->cmd_list_length + block->num_entries + 2 ) > pd->cmd_list_real_length ) {
+        dmenu_list_resize ( pd, MAX ( pd->cmd_list_real_length * 2, pd->cmd_list_length + block->num_entries + 2 ) );
+    }
+    memcpy ( &( pd->cmd_list[pd->cmd_list_length] ), block->entries, block->num_entries * sizeof ( DmenuScriptEntry ) );
+    if ( dmenu_has_match_text ( pd ) ) {
+        memcpy ( &( pd->match_text[pd->cmd_list_length] ), block->match_text, block->num_entries * sizeof ( char * ) );
+    }
+    if ( pd->columns != NULL ) {
+        memcpy ( &( pd->column_spans[pd->cmd_list_length * 2 * pd->num_columns] ), block->column_spans,
+                 block->num_entries * 2 * pd->num_columns * sizeof ( guint32 ) );
+    }
+    for ( unsigned int i = 0; i < block->num_entries; i++ ) {
+        gssize     match_len   = 0;
+        const char *match_text = dmenu_entry_match_text ( pd, pd->cmd_list_length, &match_len );
+        pd->has_meta |= ( block->entries[i].meta != NULL );
+        helper_match_cache_add ( pd->match_cache, match_text, match_len );
+        pd->cmd_list_length++;
+    }
+    pd->cmd_list[pd->cmd_list_length].entry = NULL;
+    // The entries point into the data and strings of the block, these are kept.
+    g_free ( block->entries );
+    g_free ( block->match_text );
+    g_free ( block->column_spans );
+    block->entries      = NULL;
+    block->match_text   = NULL;
+    block->column_spans = NULL;
+    g_ptr_array_add ( pd->blocks, block );
+}
+
+/**
+ * @param pd The dmenu mode data
+ *
+ * Read all input in chunks and append the rows to the store in order.
+ * Parsing in blocks would keep a second copy of the input.
+ */
+static void get_dmenu_sync_compact ( DmenuModePrivateData *pd )
+{
+    char   *buffer = g_malloc ( DMENU_READ_CHUNK_SIZE );
+    gssize nread   = 0;
+    pd->read_pending = g_string_new ( NULL );
+    while ( ( nread = g_input_stream_read ( G_INPUT_STREAM ( pd->data_input_stream ), buffer, DMENU_READ_CHUNK_SIZE, NULL, NULL ) ) > 0 ) {
+        read_add_chunk ( pd, buffer, nread );
+    }
+    // The last line does not need to end on a separator.
+    if ( pd->read_pending->len > 0 ) {
+        read_add ( pd, pd->read_pending->str, pd->read_pending->len );
+        g_string_truncate ( pd->read_pending, 0 );
+    }
+    g_free ( buffer );
+    TICK_N ( "Read input" );
+    g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+}
+
+/**
+ * @param pd The dmenu mode data
+ *
+ * Read all input. The input is read in large blocks cut on a separator, the blocks
+ * are parsed by the thread pool while the next ones are read.
+ */
 static void get_dmenu_sync ( DmenuModePrivateData *pd )
 {
-    while  ( TRUE ) {
-        gsize len   = 0;
-        char  *data = g_data_input_stream_read_upto ( pd->data_input_stream, &( pd->separator ), 1, &len, NULL, NULL );
-        if ( data == NULL ) {
-            break;
+    if ( pd->compact ) {
+        get_dmenu_sync_compact ( pd );
+        return;
+    }
+    GQueue       queue      = G_QUEUE_INIT;
+    GCond        cond;
+    GMutex       mutex;
+    // Bound the number of blocks read ahead of the parsing.
+    unsigned int max_queued = MAX ( config.threads, 1 ) * 2;
+    char         *carry     = NULL;
+    gsize        carry_len  = 0;
+    gboolean     eof        = FALSE;
+    if ( pd->blocks == NULL ) {
+        pd->blocks = g_ptr_array_new_with_free_func ( (GDestroyNotify) dmenu_parse_block_free );
+    }
+    g_cond_init ( &cond );
+    g_mutex_init ( &mutex );
+    while ( !eof ) {
+        char  *buffer = g_malloc ( carry_len + DMENU_PARSE_BLOCK_SIZE );
+        gsize nread   = 0;
+        if ( carry_len > 0 ) {
+            memcpy ( buffer, carry, carry_len );
         }
-        g_data_input_stream_read_byte ( pd->data_input_stream, NULL, NULL );
-        read_add ( pd, data, len );
-        g_free ( data );
+        g_free ( carry );
+        carry = NULL;
+        g_input_stream_read_all ( G_INPUT_STREAM ( pd->data_input_stream ), buffer + carry_len, DMENU_PARSE_BLOCK_SIZE, &nread, NULL, NULL );
+        gsize length = carry_len + nread;
+        carry_len = 0;
+        eof       = ( nread < DMENU_PARSE_BLOCK_SIZE );
+        if ( !eof ) {
+            // Cut after the last separator, the remainder starts the next block.
+            gsize cut = length;
+            while ( cut > 0 && buffer[cut - 1] != pd->separator ) {
+                cut--;
+            }
+            if ( cut == 0 ) {
+                // No complete line yet.
+                carry     = buffer;
+                carry_len = length;
+                continue;
+            }
+            carry_len = length - cut;
+            carry     = g_memdup ( buffer + cut, carry_len );
+            length    = cut;
+        }
+        if ( length == 0 ) {
+            g_free ( buffer );
+            continue;
+        }
+        DmenuParseBlock *block = g_malloc0 ( sizeof ( DmenuParseBlock ) );
+        block->st.callback = dmenu_parse_block;
+        block->pd          = pd;
+        block->data        = buffer;
+        block->length      = length;
+        block->cond        = &cond;
+        block->mutex       = &mutex;
+        if ( tpool != NULL ) {
+            g_thread_pool_push ( tpool, block, NULL );
+        }
+        else {
+            block->st.callback ( &( block->st ), NULL );
+        }
+        g_queue_push_tail ( &queue, block );
+        if ( g_queue_get_length ( &queue ) >= max_queued ) {
+            dmenu_parse_block_merge ( pd, g_queue_pop_head ( &queue ) );
+        }
+    }
+    while ( !g_queue_is_empty ( &queue ) ) {
+        dmenu_parse_block_merge ( pd, g_queue_pop_head ( &queue ) );
     }
+    // All workers are done, the merged blocks no longer refer to these.
+    g_mutex_clear ( &mutex );
+    g_cond_clear ( &cond );
+    TICK_N ( "Read input" );
     g_input_stream_close_async ( G_INPUT_STREAM ( pd->input_stream ), G_PRIORITY_LOW, pd->cancel, async_close_callback, pd );
+    dmenu_index_start ( pd );
 }
 
 static unsigned int dmenu_mode_get_num_entries ( const Mode *sw )
@@ -223,32 +1111,30 @@ static unsigned int dmenu_mode_get_num_entries ( const Mode *sw )
     return rmpd->cmd_list_length;
 }
 
-static gchar * dmenu_format_output_string ( const DmenuModePrivateData *pd, const char *input )
+static gchar * dmenu_format_output_string ( const DmenuModePrivateData *pd, unsigned int index )
 {
+    gsize      len   = 0;
+    const char *text = dmenu_row_text ( pd, index, &len );
     if ( pd->columns == NULL ) {
-        return g_strdup ( input );
-    }
-    char     *retv       = NULL;
-    char     ** splitted = g_regex_split_simple ( pd->column_separator, input, G_REGEX_CASELESS, 00 );
-    uint32_t ns          = 0;
-    for (; splitted && splitted[ns]; ns++ ) {
-        ;
-    }
-    for ( uint32_t i = 0; pd->columns && pd->columns[i]; i++ ) {
-        unsigned int index = (unsigned int ) g_ascii_strtoull ( pd->columns[i], NULL, 10 );
-        if ( index < ns && index > 0 ) {
-            if ( retv == NULL ) {
-                retv = g_strdup ( splitted[index - 1] );
-            }
-            else {
-                gchar *t = g_strjoin ( "\t", retv, splitted[index - 1], NULL );
-                g_free ( retv );
-                retv = t;
-            }
-        }
+        return g_strndup ( text, len );
     }
-    g_strfreev ( splitted );
-    return retv ? retv : g_strdup ( "" );
+    return dmenu_columns_join ( pd, text, &( pd->column_spans[index * 2 * pd->num_columns] ) );
+}
+
+/**
+ * @param pd The dmenu mode data
+ * @param index The entry to print
+ * @param filter The user input
+ *
+ * Print the entry in the output format, the entry is terminated on a copy.
+ */
+static void dmenu_output_row ( const DmenuModePrivateData *pd, unsigned int index, const char *filter )
+{
+    gsize      len   = 0;
+    const char *text = dmenu_row_text ( pd, index, &len );
+    char       *str  = g_strndup ( text, len );
+    rofi_output_formatted_line ( pd->format, str, index, filter );
+    g_free ( str );
 }
 
 static inline unsigned int get_index ( unsigned int length, int index )
@@ -266,8 +1152,7 @@ static inline unsigned int get_index ( unsigned int length, int index )
 static char *get_display_data ( const Mode *data, unsigned int index, int *state, G_GNUC_UNUSED GList **list, int get_entry )
 {
     Mode                 *sw   = (Mode *) data;
-    DmenuModePrivateData *pd   = (DmenuModePrivateData *) mode_get_private_data ( sw );
-    DmenuScriptEntry     *retv = (DmenuScriptEntry *) pd->cmd_list;
+    DmenuModePrivateData *pd = (DmenuModePrivateData *) mode_get_private_data ( sw );
     for ( unsigned int i = 0; i < pd->num_active_list; i++ ) {
         unsigned int start = get_index ( pd->cmd_list_length, pd->active_list[i].start );
         unsigned int stop  = get_index ( pd->cmd_list_length, pd->active_list[i].stop );
@@ -288,7 +1173,40 @@ static char *get_display_data ( const Mode *data, unsigned int index, int *state
     if ( pd->do_markup ) {
         *state |= MARKUP;
     }
-    return get_entry ? dmenu_format_output_string ( pd, retv[index].entry ) : NULL;
+    return get_entry ? dmenu_format_output_string ( pd, index ) : NULL;
+}
+
+static const char * dmenu_peek_completion ( const Mode *sw, unsigned int index, glong *length )
+{
+    const DmenuModePrivateData *pd = (const DmenuModePrivateData *) mode_get_private_data ( sw );
+    if ( pd->columns != NULL && !pd->match_columns ) {
+        // The completion is build from the selected columns.
+        return NULL;
+    }
+    if ( dmenu_has_match_text ( pd ) ) {
+        // Invalid markup never matches, there is nothing to score.
+        const char *text = pd->match_text[index];
+        *length = ( text != NULL ) ? g_utf8_strlen ( text, -1 ) : 0;
+        return ( text != NULL ) ? text : "";
+    }
+    if ( pd->compact ) {
+        gsize      len   = 0;
+        const char *text = dmenu_row_text ( pd, index, &len );
+        *length = g_utf8_strlen ( text, len );
+        return text;
+    }
+    *length = pd->cmd_list[index].entry_length;
+    return pd->cmd_list[index].entry;
+}
+
+static unsigned int *dmenu_token_candidates ( const Mode *sw, rofi_int_matcher **tokens, unsigned int *length )
+{
+    DmenuModePrivateData *pd    = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    RofiTrigramIndex     *index = g_atomic_pointer_get ( &( pd->index ) );
+    if ( index == NULL ) {
+        return NULL;
+    }
+    return helper_trigram_index_candidates ( index, tokens, length );
 }
 
 static void dmenu_mode_free ( Mode *sw )
@@ -312,16 +1230,36 @@ static void dmenu_mode_free ( Mode *sw )
             }
             g_object_unref ( pd->cancel );
         }
-
-        for ( size_t i = 0; i < pd->cmd_list_length; i++ ) {
-            if ( pd->cmd_list[i].entry ) {
-                g_free ( pd->cmd_list[i].entry );
-                g_free ( pd->cmd_list[i].icon_name );
-                g_free ( pd->cmd_list[i].meta );
-                g_free ( pd->cmd_list[i].info );
-            }
+        g_free ( pd->read_buffer );
+        if ( pd->read_pending != NULL ) {
+            g_string_free ( pd->read_pending, TRUE );
+        }
+        if ( pd->index_thread != NULL ) {
+            g_atomic_int_set ( &( pd->index_cancel ), TRUE );
+            g_thread_join ( pd->index_thread );
         }
+        helper_trigram_index_free ( pd->index );
+
         g_free ( pd->cmd_list );
+        g_free ( pd->row_offsets );
+        g_free ( pd->store );
+        if ( pd->row_extras != NULL ) {
+            g_hash_table_destroy ( pd->row_extras );
+        }
+        g_free ( pd->match_text );
+        g_free ( pd->column_spans );
+        g_free ( pd->columns );
+        if ( pd->column_regex != NULL ) {
+            g_regex_unref ( pd->column_regex );
+        }
+        g_string_chunk_free ( pd->strings );
+        if ( pd->blocks != NULL ) {
+            g_ptr_array_free ( pd->blocks, TRUE );
+        }
+        if ( pd->mapped != NULL ) {
+            g_mapped_file_unref ( pd->mapped );
+        }
+        helper_match_cache_free ( pd->match_cache );
         g_free ( pd->urgent_list );
         g_free ( pd->active_list );
         g_free ( pd->selected_list );
@@ -342,9 +1280,13 @@ Mode dmenu_mode =
     ._result            = NULL,
     ._destroy           = dmenu_mode_free,
     ._token_match       = dmenu_token_match,
+    ._token_match_batch = dmenu_token_match_batch,
+    ._get_string_table  = dmenu_get_string_table,
+    ._token_candidates  = dmenu_token_candidates,
     ._get_display_value = get_display_data,
     ._get_icon          = dmenu_get_icon,
     ._get_completion    = NULL,
+    ._peek_completion   = dmenu_peek_completion,
     ._preprocess_input  = NULL,
     ._get_message       = dmenu_get_message,
     .private_data       = NULL,
@@ -369,6 +1311,9 @@ static int dmenu_mode_init ( Mode *sw )
     find_arg_char ( "-sep", &( pd->separator ) );
 
     find_arg_uint (  "-selected-row", &( pd->selected_line ) );
+
+    pd->index_threshold = 100000;
+    find_arg_uint ( "-index-threshold", &( pd->index_threshold ) );
     // By default we print the unescaped line back.
     pd->format = "s";
 
@@ -420,6 +1365,14 @@ static int dmenu_mode_init ( Mode *sw )
     if ( find_arg ( "-i" ) >= 0 ) {
         config.case_sensitive = FALSE;
     }
+    // Known before reading, the markup is stripped while adding the entries.
+    if ( find_arg ( "-markup-rows" ) >= 0 ) {
+        pd->do_markup = TRUE;
+    }
+    // Known before reading, the rows are stored as they are read.
+    pd->compact     = ( find_arg ( "-compact" ) >= 0 );
+    pd->match_cache = helper_match_cache_new ();
+    pd->strings     = g_string_chunk_new ( DMENU_SCRIPT_STRINGS_CHUNK_SIZE );
     int fd = STDIN_FILENO;
     str = NULL;
     if ( find_arg_str ( "-input", &str ) ) {
@@ -433,9 +1386,26 @@ static int dmenu_mode_init ( Mode *sw )
             return TRUE;
         }
         g_free ( estr );
+        // Regular files are mapped read-only, the entries are used in place.
+        struct stat sb;
+        if ( fstat ( fd, &sb ) == 0 && S_ISREG ( sb.st_mode ) ) {
+            GError *error = NULL;
+            pd->mapped = g_mapped_file_new_from_fd ( fd, FALSE, &error );
+            if ( pd->mapped != NULL ) {
+                close ( fd );
+                if ( pd->compact && g_mapped_file_get_length ( pd->mapped ) >= G_MAXUINT32 ) {
+                    g_warning ( "Input file is too large for compact rows, storing entries instead." );
+                    pd->compact = FALSE;
+                }
+            }
+            else {
+                g_debug ( "Failed to map input file, reading it instead: %s", error->message );
+                g_error_free ( error );
+            }
+        }
     }
     // If input is stdin, and a tty, do not read as rofi grabs input and therefor blocks.
-    if ( !( fd == STDIN_FILENO && isatty ( fd ) == 1 ) ) {
+    if ( pd->mapped == NULL && !( fd == STDIN_FILENO && isatty ( fd ) == 1 ) ) {
         pd->cancel            = g_cancellable_new ();
         pd->cancel_source     = g_cancellable_connect ( pd->cancel, G_CALLBACK ( async_read_cancel ), pd, NULL );
         pd->input_stream      = g_unix_input_stream_new ( fd, fd != STDIN_FILENO );
@@ -443,47 +1413,96 @@ static int dmenu_mode_init ( Mode *sw )
     }
     gchar *columns = NULL;
     if ( find_arg_str ( "-display-columns", &columns ) ) {
-        pd->columns          = g_strsplit ( columns, ",", 0 );
-        pd->column_separator = "\t";
-        find_arg_str ( "-display-column-separator", &pd->column_separator );
+        gchar **split = g_strsplit ( columns, ",", 0 );
+        pd->columns = g_malloc0_n ( g_strv_length ( split ) + 1, sizeof ( unsigned int ) );
+        for ( unsigned int i = 0; split[i] != NULL; i++ ) {
+            unsigned int index = (unsigned int) g_ascii_strtoull ( split[i], NULL, 10 );
+            // Column 0 does not exist, it is never displayed.
+            if ( index > 0 ) {
+                pd->columns[pd->num_columns++] = index;
+                pd->max_column                 = MAX ( pd->max_column, index );
+            }
+        }
+        g_strfreev ( split );
+        char   *column_separator = "\t";
+        GError *error            = NULL;
+        find_arg_str ( "-display-column-separator", &column_separator );
+        pd->column_regex = g_regex_new ( column_separator, G_REGEX_CASELESS | G_REGEX_OPTIMIZE, 0, &error );
+        if ( error != NULL ) {
+            g_warning ( "Invalid column separator '%s': %s", column_separator, error->message );
+            g_error_free ( error );
+        }
+        pd->match_columns = ( find_arg ( "-match-display-columns" ) >= 0 );
     }
     return TRUE;
 }
 
+/**
+ * @param rmpd The dmenu private data
+ * @param tokens The tokens to match
+ * @param index The entry to match
+ *
+ * @returns TRUE if each token matches the entry or its meta data.
+ */
+static inline int dmenu_token_match_entry ( const DmenuModePrivateData *rmpd, rofi_int_matcher **tokens, unsigned int index )
+{
+    gssize     len  = 0;
+    const char *esc = dmenu_entry_match_text ( rmpd, index, &len );
+    if ( esc == NULL ) {
+        return FALSE;
+    }
+    int match = 1;
+    for ( int j = 0; match && tokens != NULL && tokens[j] != NULL; j++ ) {
+        rofi_int_matcher *ftokens[2] = { tokens[j], NULL };
+        int              test        = 0;
+        if ( helper_match_cache_usable ( rmpd->match_cache, ftokens, index ) ) {
+            test = helper_match_cache_token_match ( rmpd->match_cache, ftokens, index );
+        }
+        else {
+            test = helper_token_match_len ( ftokens, esc, len );
+        }
+        if ( test == tokens[j]->invert && rmpd->has_meta ) {
+            const DmenuScriptEntry *extras = dmenu_row_extras ( rmpd, index );
+            if ( extras != NULL && extras->meta != NULL ) {
+                test = helper_token_match ( ftokens, extras->meta );
+            }
+        }
+
+        if ( test == 0 ) {
+            match = 0;
+        }
+    }
+    return match;
+}
+
 static int dmenu_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
-    /** Strip out the markup when matching. */
-    char                 *esc = NULL;
-    if ( rmpd->do_markup ) {
-        pango_parse_markup ( rmpd->cmd_list[index].entry, -1, 0, NULL, &esc, NULL, NULL );
+    return dmenu_token_match_entry ( rmpd, tokens, index );
+}
+
+static const RofiStringTable *dmenu_get_string_table ( const Mode *sw )
+{
+    DmenuModePrivateData *rmpd = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    // Meta data needs the token match, compact rows are not copied into the table.
+    if ( rmpd->has_meta || rmpd->compact ) {
+        return NULL;
     }
-    else {
-        esc = rmpd->cmd_list[index].entry;
-    }
-    if ( esc ) {
-        //        int retv = helper_token_match ( tokens, esc );
-        int match = 1;
-        if ( tokens ) {
-            for ( int j = 0; match && tokens != NULL && tokens[j] != NULL; j++ ) {
-                rofi_int_matcher *ftokens[2] = { tokens[j], NULL };
-                int              test        = 0;
-                test = helper_token_match ( ftokens, esc );
-                if ( test == tokens[j]->invert && rmpd->cmd_list[index].meta ) {
-                    test = helper_token_match ( ftokens, rmpd->cmd_list[index].meta );
-                }
+    return helper_match_cache_get_table ( rmpd->match_cache );
+}
 
-                if ( test == 0 ) {
-                    match = 0;
-                }
-            }
-        }
-        if ( rmpd->do_markup ) {
-            g_free ( esc );
+static void dmenu_token_match_batch ( const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count )
+{
+    DmenuModePrivateData *rmpd    = (DmenuModePrivateData *) mode_get_private_data ( sw );
+    unsigned int         matched = 0;
+    // Entries are matched as stored, no per entry setup needed. Compact rows are
+    // laid out in order, so this streams over the store.
+    for ( unsigned int i = start; i < stop; i++ ) {
+        if ( dmenu_token_match_entry ( rmpd, tokens, i ) ) {
+            out[matched++] = i;
         }
-        return match;
     }
-    return FALSE;
+    *count = matched;
 }
 static char *dmenu_get_message ( const Mode *sw )
 {
@@ -496,9 +1515,9 @@ static char *dmenu_get_message ( const Mode *sw )
 static cairo_surface_t *dmenu_get_icon ( const Mode *sw, unsigned int selected_line, int height )
 {
     DmenuModePrivateData *pd = (DmenuModePrivateData *) mode_get_private_data ( sw );
-    g_return_val_if_fail ( pd->cmd_list != NULL, NULL );
-    DmenuScriptEntry     *dr = &( pd->cmd_list[selected_line] );
-    if ( dr->icon_name == NULL ) {
+    g_return_val_if_fail ( selected_line < pd->cmd_list_length, NULL );
+    DmenuScriptEntry     *dr = dmenu_row_extras ( pd, selected_line );
+    if ( dr == NULL || dr->icon_name == NULL ) {
         return NULL;
     }
     if ( dr->icon_fetch_uid > 0 ) {
@@ -526,22 +1545,22 @@ static void dmenu_finish ( RofiViewState *state, int retv )
 
 static void dmenu_print_results ( DmenuModePrivateData *pd, const char *input )
 {
-    DmenuScriptEntry *cmd_list = pd->cmd_list;
-    int              seen      = FALSE;
+    int seen = FALSE;
     if ( pd->selected_list != NULL ) {
         for ( unsigned int st = 0; st < pd->cmd_list_length; st++ ) {
             if ( bitget ( pd->selected_list, st ) ) {
                 seen = TRUE;
-                rofi_output_formatted_line ( pd->format, cmd_list[st].entry, st, input );
+                dmenu_output_row ( pd, st, input );
             }
         }
     }
     if ( !seen ) {
-        const char *cmd = input;
         if ( pd->selected_line != UINT32_MAX ) {
-            cmd = cmd_list[pd->selected_line].entry;
+            dmenu_output_row ( pd, pd->selected_line, input );
+        }
+        else {
+            rofi_output_formatted_line ( pd->format, input, pd->selected_line, input );
         }
-        rofi_output_formatted_line ( pd->format, cmd, pd->selected_line, input );
     }
 }
 
@@ -550,7 +1569,6 @@ static void dmenu_finalize ( RofiViewState *state )
     int                  retv            = FALSE;
     DmenuModePrivateData *pd             = (DmenuModePrivateData *) rofi_view_get_mode ( state )->private_data;
     unsigned int         cmd_list_length = pd->cmd_list_length;
-    DmenuScriptEntry     *cmd_list       = pd->cmd_list;
 
     char                 *input = g_strdup ( rofi_view_get_user_input ( state ) );
     pd->selected_line = rofi_view_get_selected_line ( state );;
@@ -587,8 +1605,8 @@ static void dmenu_finalize ( RofiViewState *state )
                     rofi_view_set_overlay ( state, NULL );
                 }
             }
-            else if ( ( mretv & ( MENU_OK | MENU_CUSTOM_COMMAND ) ) && cmd_list[pd->selected_line].entry != NULL ) {
-                if ( cmd_list[pd->selected_line].nonselectable == TRUE ) {
+            else if ( ( mretv & ( MENU_OK | MENU_CUSTOM_COMMAND ) ) && pd->selected_line < cmd_list_length ) {
+                if ( dmenu_row_nonselectable ( pd, pd->selected_line ) ) {
                     g_free ( input );
                     return;
                 }
@@ -616,9 +1634,9 @@ static void dmenu_finalize ( RofiViewState *state )
     // We normally do not want to restart the loop.
     restart = FALSE;
     // Normal mode
-    if ( ( mretv & MENU_OK  ) && pd->selected_line != UINT32_MAX && cmd_list[pd->selected_line].entry != NULL ) {
+    if ( ( mretv & MENU_OK  ) && pd->selected_line != UINT32_MAX && pd->selected_line < cmd_list_length ) {
         // Check if entry is non-selectable.
-        if ( cmd_list[pd->selected_line].nonselectable == TRUE ) {
+        if ( dmenu_row_nonselectable ( pd, pd->selected_line ) ) {
             g_free ( input );
             return;
         }
@@ -683,7 +1701,12 @@ int dmenu_switcher_dialog ( void )
     }
 
     // Check if the subsystem is setup for reading, otherwise do not read.
-    if ( pd->cancel != NULL ) {
+    if ( pd->mapped != NULL ) {
+        // Mapped input is read at once.
+        get_dmenu_mapped ( pd );
+        async = FALSE;
+    }
+    else if ( pd->cancel != NULL ) {
         if ( async ) {
             unsigned int pre_read = 25;
             find_arg_uint ( "-async-pre-read", &pre_read );
@@ -693,9 +1716,8 @@ int dmenu_switcher_dialog ( void )
             get_dmenu_sync ( pd );
         }
     }
-    char             *input          = NULL;
-    unsigned int     cmd_list_length = pd->cmd_list_length;
-    DmenuScriptEntry *cmd_list       = pd->cmd_list;
+    char         *input          = NULL;
+    unsigned int cmd_list_length = pd->cmd_list_length;
 
     pd->only_selected = FALSE;
     pd->multi_select  = FALSE;
@@ -703,9 +1725,6 @@ int dmenu_switcher_dialog ( void )
         menu_flags       = MENU_INDICATOR;
         pd->multi_select = TRUE;
     }
-    if ( find_arg ( "-markup-rows" ) >= 0 ) {
-        pd->do_markup = TRUE;
-    }
     if ( find_arg ( "-only-match" ) >= 0 || find_arg ( "-no-custom" ) >= 0 ) {
         pd->only_selected = TRUE;
         if ( cmd_list_length == 0 ) {
@@ -713,7 +1732,7 @@ int dmenu_switcher_dialog ( void )
         }
     }
     if ( config.auto_select && cmd_list_length == 1 ) {
-        rofi_output_formatted_line ( pd->format, cmd_list[0].entry, 0, config.filter );
+        dmenu_output_row ( pd, 0, config.filter );
         return TRUE;
     }
     if ( find_arg ( "-password" ) >= 0 ) {
@@ -728,7 +1747,9 @@ int dmenu_switcher_dialog ( void )
         rofi_int_matcher **tokens = helper_tokenize ( select, config.case_sensitive );
         unsigned int     i        = 0;
         for ( i = 0; i < cmd_list_length; i++ ) {
-            if ( helper_token_match ( tokens, cmd_list[i].entry ) ) {
+            gsize      len   = 0;
+            const char *text = dmenu_row_text ( pd, i, &len );
+            if ( helper_token_match_len ( tokens, text, len ) ) {
                 pd->selected_line = i;
                 break;
             }
@@ -739,8 +1760,10 @@ int dmenu_switcher_dialog ( void )
         rofi_int_matcher **tokens = helper_tokenize ( config.filter ? config.filter : "", config.case_sensitive );
         unsigned int     i        = 0;
         for ( i = 0; i < cmd_list_length; i++ ) {
-            if ( tokens == NULL || helper_token_match ( tokens, cmd_list[i].entry ) ) {
-                rofi_output_formatted_line ( pd->format, cmd_list[i].entry, i, config.filter );
+            gsize      len   = 0;
+            const char *text = dmenu_row_text ( pd, i, &len );
+            if ( tokens == NULL || helper_token_match_len ( tokens, text, len ) ) {
+                dmenu_output_row ( pd, i, config.filter );
             }
         }
         helper_tokenize_free ( tokens );
@@ -764,6 +1787,30 @@ int dmenu_switcher_dialog ( void )
     return FALSE;
 }
 
+int dmenu_filter_stdout ( void )
+{
+    mode_init ( &dmenu_mode );
+    DmenuModePrivateData *pd = (DmenuModePrivateData *) dmenu_mode.private_data;
+    // Filtered once, building an index does not pay off.
+    pd->index_threshold = 0;
+    if ( pd->mapped != NULL ) {
+        get_dmenu_mapped ( pd );
+    }
+    else if ( pd->cancel != NULL ) {
+        get_dmenu_sync ( pd );
+    }
+
+    unsigned int length = 0;
+    unsigned int *rows  = rofi_view_filter_rows ( &dmenu_mode, config.filter, &length );
+    for ( unsigned int i = 0; i < length; i++ ) {
+        dmenu_output_row ( pd, rows[i], config.filter );
+    }
+    fflush ( stdout );
+    g_free ( rows );
+    dmenu_mode_free ( &dmenu_mode );
+    return length > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 void print_dmenu_options ( void )
 {
     int is_term = isatty ( fileno ( stdout ) );
@@ -785,6 +1832,10 @@ void print_dmenu_options ( void )
     print_help_msg ( "-input", "[filename]", "Read input from file instead from standard input.", NULL, is_term );
     print_help_msg ( "-sync", "", "Force dmenu to first read all input data, then show dialog.", NULL, is_term );
     print_help_msg ( "-async-pre-read", "[number]", "Read several entries blocking before switching to async mode", "25", is_term );
+    print_help_msg ( "-index-threshold", "[number]", "Build a trigram index when reading at least this many entries (0 to disable)", "100000", is_term );
+    print_help_msg ( "-match-display-columns", "", "Only match the columns selected with -display-columns.", NULL, is_term );
+    print_help_msg ( "-compact", "", "Store rows compactly for very large inputs (no index).", NULL, is_term );
+    print_help_msg ( "-filter-stdout", "", "Print the entries matching -filter to stdout, without a window.", NULL, is_term );
     print_help_msg ( "-w", "windowid", "Position over window with X11 windowid.", NULL, is_term );
     print_help_msg ( "-keep-right", "", "Set ellipsize to end.", NULL, is_term );
 }
@@ -102,6 +102,8 @@ typedef struct
     char                 *exec;
     /* Name of the Entry */
     char                 *name;
+    /* Length of the name in characters */
+    glong                name_length;
     /* Generic Name */
     char                 *generic_name;
     /* Categories */
@@ -110,6 +112,8 @@ typedef struct
     char                 **keywords;
     /* Comments */
     char                 *comment;
+    /* The fields enabled for matching, separated by newlines */
+    char                 *match_record;
 
     GKeyFile             *key_file;
 
@@ -615,6 +619,7 @@ static void read_desktop_file ( DRunModePrivateData *pd, const char *root, const
     }
     pd->entry_list[pd->cmd_list_length].icon_name = g_key_file_get_locale_string ( kf, DRUN_GROUP_NAME, "Icon", NULL, NULL );
     pd->entry_list[pd->cmd_list_length].icon = NULL;
+    pd->entry_list[pd->cmd_list_length].match_record = NULL;
 
     // Keep keyfile around.
     pd->entry_list[pd->cmd_list_length].key_file = kf;
@@ -942,6 +947,57 @@ static gboolean drun_read_cache ( DRunModePrivateData *pd, const char *cache_fil
     return FALSE;
 }
 
+/**
+ * @param str The record being build
+ * @param field The field to add (can be NULL)
+ */
+static void drun_match_record_append ( GString *str, const char *field )
+{
+    if ( field == NULL ) {
+        return;
+    }
+    if ( str->len > 0 ) {
+        g_string_append_c ( str, '\n' );
+    }
+    g_string_append ( str, field );
+}
+
+/**
+ * @param e The entry
+ *
+ * Join the fields enabled for matching into one record, separated by newlines.
+ * Tokens that are not matched by a regex do not match across a newline, so one
+ * match on the record tells if any of the fields match.
+ */
+static void drun_entry_build_match_record ( DRunModeEntry *e )
+{
+    GString *str = g_string_new ( NULL );
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_NAME].enabled_match ) {
+        drun_match_record_append ( str, e->name );
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_GENERIC].enabled_match ) {
+        drun_match_record_append ( str, e->generic_name );
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_EXEC].enabled_match ) {
+        drun_match_record_append ( str, e->exec );
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_CATEGORIES].enabled_match ) {
+        for ( int iter = 0; e->categories && e->categories[iter]; iter++ ) {
+            drun_match_record_append ( str, e->categories[iter] );
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_KEYWORDS].enabled_match ) {
+        for ( int iter = 0; e->keywords && e->keywords[iter]; iter++ ) {
+            drun_match_record_append ( str, e->keywords[iter] );
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_COMMENT].enabled_match ) {
+        drun_match_record_append ( str, e->comment );
+    }
+    g_free ( e->match_record );
+    e->match_record = g_string_free ( str, FALSE );
+}
+
 static void get_apps ( DRunModePrivateData *pd )
 {
     char *cache_file = g_build_filename ( cache_dir, DRUN_DESKTOP_CACHE_FILE, NULL );
@@ -991,6 +1047,11 @@ static void get_apps ( DRunModePrivateData *pd )
         write_cache ( pd, cache_file );
     }
     g_free ( cache_file );
+    for ( unsigned int i = 0; i < pd->cmd_list_length; i++ ) {
+        pd->entry_list[i].name_length = g_utf8_strlen ( pd->entry_list[i].name, -1 );
+        drun_entry_build_match_record ( &( pd->entry_list[i] ) );
+    }
+    TICK_N ( "Build match records" );
 }
 
 static void drun_mode_parse_entry_fields ()
@@ -1082,6 +1143,7 @@ static void drun_entry_clear ( DRunModeEntry *e )
     g_free ( e->name );
     g_free ( e->generic_name );
     g_free ( e->comment );
+    g_free ( e->match_record );
     if ( e->action != DRUN_GROUP_NAME ) {
         g_free ( e->action );
     }
@@ -1320,59 +1382,91 @@ static char *drun_get_completion ( const Mode *sw, unsigned int index )
     }
 }
 
+static const char * drun_peek_completion ( const Mode *sw, unsigned int index, glong *length )
+{
+    DRunModePrivateData *pd = (DRunModePrivateData *) mode_get_private_data ( sw );
+    *length = pd->entry_list[index].name_length;
+    return pd->entry_list[index].name;
+}
+
+/**
+ * @param e The entry
+ * @param token The token to match
+ *
+ * Match the token against each of the fields enabled for matching, used for
+ * regex tokens that could match across the fields of the match record.
+ *
+ * @returns TRUE when the token matches.
+ */
+static int drun_token_match_fields ( const DRunModeEntry *e, rofi_int_matcher *token )
+{
+    int              test        = 0;
+    rofi_int_matcher *ftokens[2] = { token, NULL };
+    // Match name
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_NAME].enabled_match ) {
+        if ( e->name ) {
+            test = helper_token_match ( ftokens, e->name );
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_GENERIC].enabled_match ) {
+        // Match generic name
+        if ( test == token->invert && e->generic_name ) {
+            test = helper_token_match ( ftokens, e->generic_name );
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_EXEC].enabled_match ) {
+        // Match executable name.
+        if ( test == token->invert && e->exec ) {
+            test = helper_token_match ( ftokens, e->exec );
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_CATEGORIES].enabled_match ) {
+        // Match against category.
+        if ( test == token->invert ) {
+            gchar **list = e->categories;
+            for ( int iter = 0; test == token->invert && list && list[iter]; iter++ ) {
+                test = helper_token_match ( ftokens, list[iter] );
+            }
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_KEYWORDS].enabled_match ) {
+        // Match against category.
+        if ( test == token->invert ) {
+            gchar **list = e->keywords;
+            for ( int iter = 0; test == token->invert && list && list[iter]; iter++ ) {
+                test = helper_token_match ( ftokens, list[iter] );
+            }
+        }
+    }
+    if ( matching_entry_fields[DRUN_MATCH_FIELD_COMMENT].enabled_match ) {
+
+        // Match executable name.
+        if ( test == token->invert && e->comment ) {
+            test = helper_token_match ( ftokens, e->comment );
+        }
+    }
+    return test;
+}
+
 static int drun_token_match ( const Mode *data, rofi_int_matcher **tokens, unsigned int index )
 {
     DRunModePrivateData *rmpd = (DRunModePrivateData *) mode_get_private_data ( data );
     if ( rmpd->file_complete ){
         return rmpd->completer->_token_match (rmpd->completer, tokens, index );
     }
+    const DRunModeEntry *e    = &( rmpd->entry_list[index] );
     int                 match = 1;
     if ( tokens ) {
         for ( int j = 0; match && tokens != NULL && tokens[j] != NULL; j++ ) {
-            int              test        = 0;
-            rofi_int_matcher *ftokens[2] = { tokens[j], NULL };
-            // Match name
-            if ( matching_entry_fields[DRUN_MATCH_FIELD_NAME].enabled_match ) {
-                if ( rmpd->entry_list[index].name ) {
-                    test = helper_token_match ( ftokens, rmpd->entry_list[index].name );
-                }
-            }
-            if ( matching_entry_fields[DRUN_MATCH_FIELD_GENERIC].enabled_match ) {
-                // Match generic name
-                if ( test == tokens[j]->invert && rmpd->entry_list[index].generic_name ) {
-                    test = helper_token_match ( ftokens, rmpd->entry_list[index].generic_name );
-                }
-            }
-            if ( matching_entry_fields[DRUN_MATCH_FIELD_EXEC].enabled_match ) {
-                // Match executable name.
-                if ( test == tokens[j]->invert && rmpd->entry_list[index].exec ) {
-                    test = helper_token_match ( ftokens, rmpd->entry_list[index].exec );
-                }
+            int test = 0;
+            // Tokens matched by a regex (regex, glob or the full case fold fallback) are matched field by field.
+            if ( tokens[j]->pattern == NULL || e->match_record == NULL || e->match_record[0] == '\0' ) {
+                test = drun_token_match_fields ( e, tokens[j] );
             }
-            if ( matching_entry_fields[DRUN_MATCH_FIELD_CATEGORIES].enabled_match ) {
-                // Match against category.
-                if ( test == tokens[j]->invert ) {
-                    gchar **list = rmpd->entry_list[index].categories;
-                    for ( int iter = 0; test == tokens[j]->invert && list && list[iter]; iter++ ) {
-                        test = helper_token_match ( ftokens, list[iter] );
-                    }
-                }
-            }
-            if ( matching_entry_fields[DRUN_MATCH_FIELD_KEYWORDS].enabled_match ) {
-                // Match against category.
-                if ( test == tokens[j]->invert ) {
-                    gchar **list = rmpd->entry_list[index].keywords;
-                    for ( int iter = 0; test == tokens[j]->invert && list && list[iter]; iter++ ) {
-                        test = helper_token_match ( ftokens, list[iter] );
-                    }
-                }
-            }
-            if ( matching_entry_fields[DRUN_MATCH_FIELD_COMMENT].enabled_match ) {
-
-                // Match executable name.
-                if ( test == tokens[j]->invert && rmpd->entry_list[index].comment ) {
-                    test = helper_token_match ( ftokens, rmpd->entry_list[index].comment );
-                }
+            else {
+                // One pass over all fields, tokens do not match across the newlines.
+                rofi_int_matcher *ftokens[2] = { tokens[j], NULL };
+                test = helper_token_match ( ftokens, e->match_record );
             }
             if ( test == 0 ) {
                 match = 0;
@@ -1419,6 +1513,7 @@ Mode drun_mode =
     ._token_match       = drun_token_match,
     ._get_message       = drun_get_message,
     ._get_completion    = drun_get_completion,
+    ._peek_completion   = drun_peek_completion,
     ._get_display_value = _get_display_value,
     ._get_icon          = _get_icon,
     ._preprocess_input  = NULL,
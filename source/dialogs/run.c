@@ -65,6 +65,8 @@
 typedef struct
 {
     char            *entry;
+    /* Length of the entry in characters */
+    unsigned int    entry_length;
     uint32_t        icon_fetch_uid;
     /* Surface holding the icon. */
     cairo_surface_t *icon;
@@ -79,6 +81,8 @@ typedef struct
     RunEntry     *cmd_list;
     /** Length of the #cmd_list. */
     unsigned int cmd_list_length;
+    /** The commands in the form they are matched. */
+    RofiMatchCache *match_cache;
 
     /** Current mode. */
     gboolean     file_complete;
@@ -384,7 +388,12 @@ static int run_mode_init ( Mode *sw )
         RunModePrivateData *pd = g_malloc0 ( sizeof ( *pd ) );
         sw->private_data = (void *) pd;
         pd->cmd_list     = get_apps ( &( pd->cmd_list_length ) );
-        pd->completer    = create_new_file_browser ();
+        pd->match_cache  = helper_match_cache_new ();
+        for ( unsigned int i = 0; i < pd->cmd_list_length; i++ ) {
+            pd->cmd_list[i].entry_length = g_utf8_strlen ( pd->cmd_list[i].entry, -1 );
+            helper_match_cache_add ( pd->match_cache, pd->cmd_list[i].entry, -1 );
+        }
+        pd->completer = create_new_file_browser ();
         mode_init ( pd->completer );
     }
 
@@ -401,6 +410,7 @@ static void run_mode_destroy ( Mode *sw )
             }
         }
         g_free ( rmpd->cmd_list );
+        helper_match_cache_free ( rmpd->match_cache );
         g_free ( rmpd->old_input );
         g_free ( rmpd->old_completer_input );
         mode_destroy ( rmpd->completer );
@@ -503,6 +513,16 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
     return get_entry ? g_strdup ( rmpd->cmd_list[selected_line].entry ) : NULL;
 }
 
+static const char * run_peek_completion ( const Mode *sw, unsigned int index, glong *length )
+{
+    const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
+    if ( rmpd->file_complete ) {
+        return mode_peek_completion ( rmpd->completer, index, length );
+    }
+    *length = rmpd->cmd_list[index].entry_length;
+    return rmpd->cmd_list[index].entry;
+}
+
 static int run_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
@@ -511,6 +531,16 @@ static int run_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned
     }
     return helper_token_match ( tokens, rmpd->cmd_list[index].entry );
 }
+
+static const RofiStringTable *run_get_string_table ( const Mode *sw )
+{
+    const RunModePrivateData *rmpd = (const RunModePrivateData *) sw->private_data;
+    if ( rmpd->file_complete ) {
+        // Matching is done by the file browser.
+        return NULL;
+    }
+    return helper_match_cache_get_table ( rmpd->match_cache );
+}
 static char *run_get_message ( const Mode *sw )
 {
     RunModePrivateData *pd = sw->private_data;
@@ -578,10 +608,12 @@ Mode run_mode =
     ._result            = run_mode_result,
     ._destroy           = run_mode_destroy,
     ._token_match       = run_token_match,
+    ._get_string_table  = run_get_string_table,
     ._get_message       = run_get_message,
     ._get_display_value = _get_display_value,
     ._get_icon          = _get_icon,
     ._get_completion    = NULL,
+    ._peek_completion   = run_peek_completion,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
     .free               = NULL
@@ -57,6 +57,12 @@ typedef struct
     DmenuScriptEntry       *cmd_list;
     /** length list of visible items. */
     unsigned int           cmd_list_length;
+    /** Strings of the visible items. */
+    GStringChunk           *strings;
+    /** The entries in the form they are matched. */
+    RofiMatchCache         *match_cache;
+    /** One of the entries has meta data, this is matched besides the entry. */
+    gboolean               has_meta;
 
     /** Urgent list */
     struct rofi_range_pair * urgent_list;
@@ -75,35 +81,52 @@ typedef struct
     gboolean               use_hot_keys;
 } ScriptModePrivateData;
 
+/**
+ * @param key The key.
+ * @param length The length of the key.
+ * @param name The name to compare against.
+ *
+ * @returns TRUE if the key equals name, ignoring case.
+ */
+static inline gboolean dmenuscript_extras_key_is ( const char *key, size_t length, const char *name )
+{
+    return strlen ( name ) == length && g_ascii_strncasecmp ( key, name, length ) == 0;
+}
+
 /**
  * Shared function between DMENU and Script mode.
  */
-void dmenuscript_parse_entry_extras ( G_GNUC_UNUSED Mode *sw, DmenuScriptEntry *entry, char *buffer, G_GNUC_UNUSED size_t length )
+void dmenuscript_parse_entry_extras ( G_GNUC_UNUSED Mode *sw, GStringChunk *strings, DmenuScriptEntry *entry, const char *buffer, size_t length )
 {
-    gchar **extras = g_strsplit ( buffer, "\x1f", -1 );
-    gchar **extra;
-    for ( extra = extras; *extra != NULL && *( extra + 1 ) != NULL; extra += 2 ) {
-        gchar *key   = *extra;
-        gchar *value = *( extra + 1 );
-        if ( strcasecmp ( key, "icon" ) == 0 ) {
-            entry->icon_name = value;
+    // Pairs of key and value, all separated by '\x1f'. Parsed in place, only the values are copied.
+    const char *end = memchr ( buffer, '\0', length );
+    if ( end == NULL ) {
+        end = buffer + length;
+    }
+    const char *key = buffer;
+    const char *sep = NULL;
+    while ( ( sep = memchr ( key, '\x1f', end - key ) ) != NULL ) {
+        size_t     key_length   = sep - key;
+        const char *value       = sep + 1;
+        const char *next        = memchr ( value, '\x1f', end - value );
+        size_t     value_length = ( next != NULL ) ? (size_t) ( next - value ) : (size_t) ( end - value );
+        if ( dmenuscript_extras_key_is ( key, key_length, "icon" ) ) {
+            entry->icon_name = g_string_chunk_insert_len ( strings, value, value_length );
         }
-        else if ( strcasecmp ( key, "meta" ) == 0 ) {
-            entry->meta = value;
+        else if ( dmenuscript_extras_key_is ( key, key_length, "meta" ) ) {
+            entry->meta = g_string_chunk_insert_len ( strings, value, value_length );
         }
-        else if ( strcasecmp ( key, "info" ) == 0 ) {
-            entry->info = value;
+        else if ( dmenuscript_extras_key_is ( key, key_length, "info" ) ) {
+            entry->info = g_string_chunk_insert_len ( strings, value, value_length );
         }
-        else if ( strcasecmp ( key, "nonselectable" ) == 0 ) {
-            entry->nonselectable = strcasecmp ( value, "true" ) == 0;
-            g_free ( value );
+        else if ( dmenuscript_extras_key_is ( key, key_length, "nonselectable" ) ) {
+            entry->nonselectable = dmenuscript_extras_key_is ( value, value_length, "true" );
         }
-        else {
-            g_free ( value );
+        if ( next == NULL ) {
+            break;
         }
-        g_free ( key );
+        key = next + 1;
     }
-    g_free ( extras );
 }
 
 /**
@@ -151,7 +174,19 @@ static void parse_header_entry ( Mode *sw, char *line, ssize_t length )
     }
 }
 
-static DmenuScriptEntry *execute_executor ( Mode *sw, char *arg, unsigned int *length, int value, DmenuScriptEntry *entry )
+/**
+ * @param sw The script mode
+ * @param arg The argument to pass to the script.
+ * @param length Set to the number of entries returned.
+ * @param value The value of ROFI_RETV.
+ * @param entry The selected entry, or NULL.
+ * @param strings Set to the string chunk holding the strings of the returned entries.
+ *
+ * Execute the script and read the new list of entries.
+ *
+ * @returns the new list of entries, or NULL if none.
+ */
+static DmenuScriptEntry *execute_executor ( Mode *sw, char *arg, unsigned int *length, int value, DmenuScriptEntry *entry, GStringChunk **strings )
 {
     ScriptModePrivateData *pd    = (ScriptModePrivateData *) sw->private_data;
     int                   fd     = -1;
@@ -159,7 +194,8 @@ static DmenuScriptEntry *execute_executor ( Mode *sw, char *arg, unsigned int *l
     DmenuScriptEntry      *retv  = NULL;
     char                  **argv = NULL;
     int                   argc   = 0;
-    *length = 0;
+    *length  = 0;
+    *strings = NULL;
 
     // Environment
     char ** env = g_get_environ ();
@@ -211,15 +247,20 @@ static DmenuScriptEntry *execute_executor ( Mode *sw, char *arg, unsigned int *l
                         actual_size += 256;
                         retv         = g_realloc ( retv, ( actual_size ) * sizeof ( DmenuScriptEntry ) );
                     }
+                    if ( *strings == NULL ) {
+                        *strings = g_string_chunk_new ( DMENU_SCRIPT_STRINGS_CHUNK_SIZE );
+                    }
                     size_t buf_length = strlen ( buffer ) + 1;
-                    retv[( *length )].entry          = g_memdup ( buffer, buf_length );
+                    retv[( *length )].entry          = g_string_chunk_insert_len ( *strings, buffer, buf_length - 1 );
+                    retv[( *length )].entry_length   = g_utf8_strlen ( buffer, buf_length - 1 );
+                    retv[( *length )].entry_size     = buf_length - 1;
                     retv[( *length )].icon_name      = NULL;
                     retv[( *length )].meta           = NULL;
                     retv[( *length )].info           = NULL;
                     retv[( *length )].icon_fetch_uid = 0;
                     retv[( *length )].nonselectable  = FALSE;
                     if ( buf_length > 0 && ( read_length > (ssize_t) buf_length )  ) {
-                        dmenuscript_parse_entry_extras ( sw, &( retv[( *length )] ), buffer + buf_length, read_length - buf_length );
+                        dmenuscript_parse_entry_extras ( sw, *strings, &( retv[( *length )] ), buffer + buf_length, read_length - buf_length );
                     }
                     retv[( *length ) + 1].entry = NULL;
                     ( *length )++;
@@ -248,13 +289,30 @@ static void script_switcher_free ( Mode *sw )
     g_free ( sw );
 }
 
+/**
+ * @param pd The script mode private data
+ *
+ * (Re)build the match cache from the current list.
+ */
+static void script_mode_build_match_cache ( ScriptModePrivateData *pd )
+{
+    helper_match_cache_free ( pd->match_cache );
+    pd->match_cache = helper_match_cache_new ();
+    pd->has_meta    = FALSE;
+    for ( unsigned int i = 0; i < pd->cmd_list_length; i++ ) {
+        helper_match_cache_add ( pd->match_cache, pd->cmd_list[i].entry, pd->cmd_list[i].entry_size );
+        pd->has_meta |= ( pd->cmd_list[i].meta != NULL );
+    }
+}
+
 static int script_mode_init ( Mode *sw )
 {
     if ( sw->private_data == NULL ) {
         ScriptModePrivateData *pd = g_malloc0 ( sizeof ( *pd ) );
         pd->delim        = '\n';
         sw->private_data = (void *) pd;
-        pd->cmd_list     = execute_executor ( sw, NULL, &( pd->cmd_list_length ), 0, NULL );
+        pd->cmd_list     = execute_executor ( sw, NULL, &( pd->cmd_list_length ), 0, NULL, &( pd->strings ) );
+        script_mode_build_match_cache ( pd );
     }
     return TRUE;
 }
@@ -282,16 +340,17 @@ static ModeMode script_mode_result ( Mode *sw, int mretv, char **input, unsigned
     ModeMode              retv       = MODE_EXIT;
     DmenuScriptEntry      *new_list  = NULL;
     unsigned int          new_length = 0;
+    GStringChunk          *strings   = NULL;
 
     if ( ( mretv & MENU_CUSTOM_COMMAND ) ) {
         if ( rmpd->use_hot_keys ) {
             script_mode_reset_highlight ( sw );
             if ( selected_line != UINT32_MAX ) {
-                new_list = execute_executor ( sw, rmpd->cmd_list[selected_line].entry, &new_length, 10 + ( mretv & MENU_LOWER_MASK ), &( rmpd->cmd_list[selected_line] ) );
+                new_list = execute_executor ( sw, rmpd->cmd_list[selected_line].entry, &new_length, 10 + ( mretv & MENU_LOWER_MASK ), &( rmpd->cmd_list[selected_line] ), &strings );
             }
             else {
                 if ( rmpd->no_custom == FALSE ) {
-                    new_list = execute_executor ( sw, *input, &new_length, 10 + ( mretv & MENU_LOWER_MASK ), NULL );
+                    new_list = execute_executor ( sw, *input, &new_length, 10 + ( mretv & MENU_LOWER_MASK ), NULL, &strings );
                 }
                 else {
                     return RELOAD_DIALOG;
@@ -308,12 +367,12 @@ static ModeMode script_mode_result ( Mode *sw, int mretv, char **input, unsigned
             return RELOAD_DIALOG;
         }
         script_mode_reset_highlight ( sw );
-        new_list = execute_executor ( sw, rmpd->cmd_list[selected_line].entry, &new_length, 1, &( rmpd->cmd_list[selected_line] ) );
+        new_list = execute_executor ( sw, rmpd->cmd_list[selected_line].entry, &new_length, 1, &( rmpd->cmd_list[selected_line] ), &strings );
     }
     else if ( ( mretv & MENU_CUSTOM_INPUT ) && *input != NULL && *input[0] != '\0' ) {
         if ( rmpd->no_custom == FALSE ) {
             script_mode_reset_highlight ( sw );
-            new_list = execute_executor ( sw, *input, &new_length, 2, NULL );
+            new_list = execute_executor ( sw, *input, &new_length, 2, NULL, &strings );
         }
         else {
             return RELOAD_DIALOG;
@@ -322,16 +381,16 @@ static ModeMode script_mode_result ( Mode *sw, int mretv, char **input, unsigned
 
     // If a new list was generated, use that an loop around.
     if ( new_list != NULL ) {
-        for ( unsigned int i = 0; i < rmpd->cmd_list_length; i++ ) {
-            g_free ( rmpd->cmd_list[i].entry );
-            g_free ( rmpd->cmd_list[i].icon_name );
-            g_free ( rmpd->cmd_list[i].meta );
-        }
         g_free ( rmpd->cmd_list );
+        if ( rmpd->strings != NULL ) {
+            g_string_chunk_free ( rmpd->strings );
+        }
 
         rmpd->cmd_list        = new_list;
+        rmpd->strings         = strings;
         rmpd->cmd_list_length = new_length;
-        retv                  = RESET_DIALOG;
+        script_mode_build_match_cache ( rmpd );
+        retv = RESET_DIALOG;
     }
     return retv;
 }
@@ -340,12 +399,11 @@ static void script_mode_destroy ( Mode *sw )
 {
     ScriptModePrivateData *rmpd = (ScriptModePrivateData *) sw->private_data;
     if ( rmpd != NULL ) {
-        for ( unsigned int i = 0; i < rmpd->cmd_list_length; i++ ) {
-            g_free ( rmpd->cmd_list[i].entry );
-            g_free ( rmpd->cmd_list[i].icon_name );
-            g_free ( rmpd->cmd_list[i].meta );
-        }
         g_free ( rmpd->cmd_list );
+        if ( rmpd->strings != NULL ) {
+            g_string_chunk_free ( rmpd->strings );
+        }
+        helper_match_cache_free ( rmpd->match_cache );
         g_free ( rmpd->message );
         g_free ( rmpd->prompt );
         g_free ( rmpd->urgent_list );
@@ -388,6 +446,13 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
     return get_entry ? g_strdup ( pd->cmd_list[selected_line].entry ) : NULL;
 }
 
+static const char * script_peek_completion ( const Mode *sw, unsigned int index, glong *length )
+{
+    const ScriptModePrivateData *pd = sw->private_data;
+    *length = pd->cmd_list[index].entry_length;
+    return pd->cmd_list[index].entry;
+}
+
 static int script_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     ScriptModePrivateData *rmpd = sw->private_data;
@@ -408,6 +473,15 @@ static int script_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsig
     }
     return match;
 }
+static const RofiStringTable *script_get_string_table ( const Mode *sw )
+{
+    ScriptModePrivateData *rmpd = sw->private_data;
+    // Meta data is matched besides the entry, this needs the token match.
+    if ( rmpd->has_meta ) {
+        return NULL;
+    }
+    return helper_match_cache_get_table ( rmpd->match_cache );
+}
 static char *script_get_message ( const Mode *sw )
 {
     ScriptModePrivateData *pd = sw->private_data;
@@ -453,9 +527,11 @@ Mode *script_switcher_parse_setup ( const char *str )
         sw->_result            = script_mode_result;
         sw->_destroy           = script_mode_destroy;
         sw->_token_match       = script_token_match;
+        sw->_get_string_table  = script_get_string_table;
         sw->_get_message       = script_get_message;
         sw->_get_icon          = script_get_icon;
         sw->_get_completion    = NULL,
+        sw->_peek_completion   = script_peek_completion,
         sw->_preprocess_input  = NULL,
         sw->_get_display_value = _get_display_value;
 
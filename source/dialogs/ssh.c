@@ -62,9 +62,11 @@
 typedef struct _SshEntry
 {
     /** SSH hostname */
-    char *hostname;
+    char         *hostname;
+    /** Length of the hostname in characters */
+    unsigned int hostname_length;
     /** SSH port number */
-    int  port;
+    int          port;
 } SshEntry;
 /**
  * The internal data structure holding the private data of the SSH Mode.
@@ -75,7 +77,9 @@ typedef struct
     /** List if available ssh hosts.*/
     SshEntry     *hosts_list;
     /** Length of the #hosts_list.*/
-    unsigned int hosts_list_length;
+    unsigned int   hosts_list_length;
+    /** The host names in the form they are matched. */
+    RofiMatchCache *match_cache;
 } SSHModePrivateData;
 
 /**
@@ -543,7 +547,12 @@ static int ssh_mode_init ( Mode *sw )
     if ( mode_get_private_data ( sw ) == NULL ) {
         SSHModePrivateData *pd = g_malloc0 ( sizeof ( *pd ) );
         mode_set_private_data ( sw, (void *) pd );
-        pd->hosts_list = get_ssh ( pd, &( pd->hosts_list_length ) );
+        pd->hosts_list  = get_ssh ( pd, &( pd->hosts_list_length ) );
+        pd->match_cache = helper_match_cache_new ();
+        for ( unsigned int i = 0; i < pd->hosts_list_length; i++ ) {
+            pd->hosts_list[i].hostname_length = g_utf8_strlen ( pd->hosts_list[i].hostname, -1 );
+            helper_match_cache_add ( pd->match_cache, pd->hosts_list[i].hostname, -1 );
+        }
     }
     return TRUE;
 }
@@ -574,6 +583,7 @@ static void ssh_mode_destroy ( Mode *sw )
         }
         g_list_free_full ( rmpd->user_known_hosts, g_free );
         g_free ( rmpd->hosts_list );
+        helper_match_cache_free ( rmpd->match_cache );
         g_free ( rmpd );
         mode_set_private_data ( sw, NULL );
     }
@@ -631,6 +641,13 @@ static char *_get_display_value ( const Mode *sw, unsigned int selected_line, G_
     return get_entry ? g_strdup ( rmpd->hosts_list[selected_line].hostname ) : NULL;
 }
 
+static const char * ssh_peek_completion ( const Mode *sw, unsigned int selected_line, glong *length )
+{
+    SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
+    *length = rmpd->hosts_list[selected_line].hostname_length;
+    return rmpd->hosts_list[selected_line].hostname;
+}
+
 /**
  * @param sw Object handle to the SSH Mode object
  * @param tokens The set of tokens to match against
@@ -645,6 +662,17 @@ static int ssh_token_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned
     SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
     return helper_token_match ( tokens, rmpd->hosts_list[index].hostname );
 }
+
+/**
+ * @param sw Object handle to the SSH Mode object
+ *
+ * @returns the table with the host names, as they are matched.
+ */
+static const RofiStringTable *ssh_get_string_table ( const Mode *sw )
+{
+    SSHModePrivateData *rmpd = (SSHModePrivateData *) mode_get_private_data ( sw );
+    return helper_match_cache_get_table ( rmpd->match_cache );
+}
 #include "mode-private.h"
 Mode ssh_mode =
 {
@@ -655,8 +683,10 @@ Mode ssh_mode =
     ._result            = ssh_mode_result,
     ._destroy           = ssh_mode_destroy,
     ._token_match       = ssh_token_match,
+    ._get_string_table  = ssh_get_string_table,
     ._get_display_value = _get_display_value,
     ._get_completion    = NULL,
+    ._peek_completion   = ssh_peek_completion,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
     .free               = NULL
@@ -137,6 +137,10 @@ typedef struct
     unsigned int title_len;
     unsigned int role_len;
     GRegex       *window_regex;
+    // Display string of each window in ids, scored when sorting.
+    char         **display;
+    // Length of each display string in characters.
+    glong        *display_length;
 } ModeModePrivateData;
 
 winlist *cache_client = NULL;
@@ -365,6 +369,18 @@ static client* window_client ( ModeModePrivateData *pd, xcb_window_t win )
     g_free ( attr );
     return c;
 }
+static char * _generate_display_string ( const ModeModePrivateData *pd, client *c );
+static const char * window_peek_completion ( const Mode *sw, unsigned int index, glong *length )
+{
+    ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
+    // Built when the list was loaded, X calls are not thread safe.
+    if ( rmpd->display == NULL || rmpd->display[index] == NULL ) {
+        return NULL;
+    }
+    *length = rmpd->display_length[index];
+    return rmpd->display[index];
+}
+
 static int window_match ( const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
 {
     ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
@@ -596,6 +612,16 @@ static void _window_mode_load_data ( Mode *sw, unsigned int cd )
                 winlist_append ( pd->ids, c->window, NULL );
             }
         }
+        // The field widths are known now, build the strings the rows are sorted on.
+        pd->display        = g_malloc0_n ( pd->ids->len, sizeof ( char * ) );
+        pd->display_length = g_malloc0_n ( pd->ids->len, sizeof ( glong ) );
+        for ( i = 0; i < pd->ids->len; i++ ) {
+            client *c = window_client ( pd, pd->ids->array[i] );
+            if ( c != NULL ) {
+                pd->display[i]        = _generate_display_string ( pd, c );
+                pd->display_length[i] = g_utf8_strlen ( pd->display[i], -1 );
+            }
+        }
 
         if ( has_names ) {
             xcb_ewmh_get_utf8_strings_reply_wipe ( &names );
@@ -738,6 +764,13 @@ static void window_mode_destroy ( Mode *sw )
 {
     ModeModePrivateData *rmpd = (ModeModePrivateData *) mode_get_private_data ( sw );
     if ( rmpd != NULL ) {
+        if ( rmpd->display != NULL ) {
+            for ( int i = 0; i < rmpd->ids->len; i++ ) {
+                g_free ( rmpd->display[i] );
+            }
+            g_free ( rmpd->display );
+            g_free ( rmpd->display_length );
+        }
         winlist_free ( rmpd->ids );
         x11_cache_free ();
         g_free ( rmpd->cache );
@@ -973,6 +1006,7 @@ Mode window_mode =
     ._get_display_value = _get_display_value,
     ._get_icon          = _get_icon,
     ._get_completion    = NULL,
+    ._peek_completion   = window_peek_completion,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
     .free               = NULL
@@ -989,6 +1023,7 @@ Mode window_mode_cd =
     ._get_display_value = _get_display_value,
     ._get_icon          = _get_icon,
     ._get_completion    = NULL,
+    ._peek_completion   = window_peek_completion,
     ._preprocess_input  = NULL,
     .private_data       = NULL,
     .free               = NULL
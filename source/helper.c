@@ -122,11 +122,72 @@ int helper_parse_setup ( char * string, char ***output, int *length, ... )
     return FALSE;
 }
 
+/** Number of compiled matchers kept for reuse by the next tokenize. */
+#define MATCHER_CACHE_ENTRIES    32
+
+/**
+ * A compiled matcher and the token and settings it was created from.
+ */
+typedef struct
+{
+    /** The token, including the negate character. */
+    char             *token;
+    /** Matching method used. */
+    int              method;
+    /** Case sensitivity used. */
+    int              case_sensitive;
+    /** Normalize setting used. */
+    int              normalize_match;
+    /** The matcher, the cache holds a reference. */
+    rofi_int_matcher *matcher;
+} matcher_cache_entry;
+
+/** Recently compiled matchers, most recently used first. */
+static GQueue matcher_cache = G_QUEUE_INIT;
+G_LOCK_DEFINE_STATIC ( matcher_cache );
+
+/**
+ * @param m The matcher
+ *
+ * Drop a reference to the matcher, freeing it when it was the last one.
+ */
+static void matcher_unref ( rofi_int_matcher *m )
+{
+    if ( !g_atomic_int_dec_and_test ( &( m->refcount ) ) ) {
+        return;
+    }
+    if ( m->regex != NULL ) {
+        g_regex_unref ( (GRegex *) m->regex );
+    }
+    g_free ( m->pattern );
+    g_free ( m->chars );
+    g_free ( m );
+}
+
+/**
+ * @param e The entry to free
+ */
+static void matcher_cache_entry_free ( matcher_cache_entry *e )
+{
+    matcher_unref ( e->matcher );
+    g_free ( e->token );
+    g_free ( e );
+}
+
+void helper_tokenize_cache_clear ( void )
+{
+    G_LOCK ( matcher_cache );
+    matcher_cache_entry *e;
+    while ( ( e = g_queue_pop_head ( &matcher_cache ) ) != NULL ) {
+        matcher_cache_entry_free ( e );
+    }
+    G_UNLOCK ( matcher_cache );
+}
+
 void helper_tokenize_free ( rofi_int_matcher ** tokens )
 {
     for ( size_t i = 0; tokens && tokens[i]; i++ ) {
-        g_regex_unref ( (GRegex *) tokens[i]->regex );
-        g_free ( tokens[i] );
+        matcher_unref ( tokens[i] );
     }
     g_free ( tokens );
 }
@@ -148,6 +209,302 @@ static gchar *glob_to_regex ( const char *input )
     }
     return r;
 }
+/**
+ * @param uc The character
+ *
+ * @returns the first character of the full decomposition of uc, stripping accents.
+ */
+static inline gunichar utf8_helper_simplify_char ( gunichar uc )
+{
+    gunichar buf[G_UNICHAR_MAX_DECOMPOSITION_LENGTH] = { 0, };
+    gsize    dl                                      = g_unichar_fully_decompose ( uc, FALSE, buf, G_UNICHAR_MAX_DECOMPOSITION_LENGTH );
+    return dl ? buf[0] : uc;
+}
+
+/**
+ * @param s The string
+ * @param length The length of s in bytes, or -1 if s is terminated.
+ *
+ * @returns a newly allocated, terminated copy of s with the accents stripped.
+ */
+static char *utf8_helper_simplify_string ( const char *s, gssize length )
+{
+    if ( length < 0 ) {
+        length = strlen ( s );
+    }
+    // Compose the string in maximally composed form.
+    char * str    = g_malloc0 ( ( g_utf8_strlen ( s, length ) * 6 + 2 ) );
+    char *striter = str;
+    for ( const char *iter = s; iter < s + length; iter = g_utf8_next_char ( iter ) ) {
+        striter += g_unichar_to_utf8 ( utf8_helper_simplify_char ( g_utf8_get_char ( iter ) ), striter );
+    }
+
+    return str;
+}
+
+// Macro for quickly generating regex for matching.
+static inline GRegex * R ( const char *s, int case_sensitive  )
+{
+    if ( config.normalize_match ) {
+        char   *str = utf8_helper_simplify_string ( s, -1 );
+
+        GRegex *r = g_regex_new ( str, G_REGEX_OPTIMIZE | ( ( case_sensitive ) ? 0 : G_REGEX_CASELESS ), 0, NULL );
+
+        g_free ( str );
+        return r;
+    }
+    else {
+        return g_regex_new ( s, G_REGEX_OPTIMIZE | ( ( case_sensitive ) ? 0 : G_REGEX_CASELESS ), 0, NULL );
+    }
+}
+
+/**
+ * @param fold If the character should be case folded
+ * @param c The character
+ *
+ * @returns the character in the form it is compared by the matcher.
+ */
+static inline gunichar matcher_fold ( gboolean fold, gunichar c )
+{
+    if ( !fold ) {
+        return c;
+    }
+    if ( c < 0x80 ) {
+        return g_ascii_tolower ( c );
+    }
+    // Like a caseless regex, all cases of a character compare equal (σ, ς and Σ),
+    // the dotted and dotless i only match themselves.
+    if ( c == 0x130 || c == 0x131 ) {
+        return c;
+    }
+    return g_unichar_tolower ( g_unichar_toupper ( c ) );
+}
+
+/**
+ * @param iter Pointer to the current position, moved to the next character.
+ *
+ * Decode the character at iter, ASCII is handled without a call into glib.
+ *
+ * @returns the character at iter.
+ */
+static inline gunichar matcher_next_char ( const char **iter )
+{
+    const char *s = *iter;
+    if ( (guchar) s[0] < 0x80 ) {
+        ( *iter )++;
+        return (gunichar) s[0];
+    }
+    *iter = g_utf8_next_char ( s );
+    return g_utf8_get_char ( s );
+}
+
+/**
+ * @param c The character
+ *
+ * @returns TRUE if c is a word character (as used by \b in a regex)
+ */
+static gboolean matcher_is_word ( gunichar c )
+{
+    if ( c == '_' || g_unichar_isalpha ( c ) ) {
+        return TRUE;
+    }
+    switch ( g_unichar_type ( c ) )
+    {
+    case G_UNICODE_DECIMAL_NUMBER:
+    case G_UNICODE_LETTER_NUMBER:
+    case G_UNICODE_OTHER_NUMBER:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/**
+ * @param input The string
+ * @param end The end of input
+ * @param pos Position in input
+ *
+ * @returns TRUE if there is a word boundary at pos.
+ */
+static gboolean matcher_word_boundary ( const char *input, const char *end, const char *pos )
+{
+    gboolean before = pos > input && matcher_is_word ( g_utf8_get_char ( g_utf8_find_prev_char ( input, pos ) ) );
+    gboolean after  = pos < end && matcher_is_word ( g_utf8_get_char ( pos ) );
+    return before != after;
+}
+
+/**
+ * @param m The matcher
+ * @param from Position to start searching
+ * @param end The end of the searched text
+ * @param match_end Set to the end of the match
+ * @param fold If the searched text needs case folding
+ *
+ * Find the pattern as literal text. When the text does not need folding this
+ * is a plain byte search (UTF-8 matches can only start on a character boundary).
+ *
+ * @returns the start of the first match, or NULL if not found.
+ */
+static const char *matcher_literal_find ( const rofi_int_matcher *m, const char *from, const char *end, const char **match_end, gboolean fold )
+{
+    if ( !fold ) {
+        const char *hit = memmem ( from, end - from, m->pattern, m->pattern_len );
+        if ( hit != NULL ) {
+            *match_end = hit + m->pattern_len;
+        }
+        return hit;
+    }
+    gunichar first = m->chars[0];
+    for ( const char *start = from; start < end; start = g_utf8_next_char ( start ) ) {
+        // Skip ASCII that cannot start the match without decoding, only ASCII folds to ASCII.
+        // Other characters can fold to ASCII (e.g. KELVIN SIGN), these are compared.
+        if ( (guchar) start[0] < 0x80 && ( first >= 0x80 || (gunichar) g_ascii_tolower ( start[0] ) != first ) ) {
+            continue;
+        }
+        const char *iter = start;
+        glong      i     = 0;
+        while ( i < m->num_chars && iter < end && matcher_fold ( fold, matcher_next_char ( &iter ) ) == m->chars[i] ) {
+            i++;
+        }
+        if ( i == m->num_chars ) {
+            *match_end = iter;
+            return start;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @param m The matcher
+ * @param input The string to match
+ * @param end The end of input
+ * @param from Position in input to start searching
+ * @param ranges Filled with the byte ranges of the match, room for num_chars entries.
+ * @param fold If input needs case folding
+ *
+ * Find the next match of a normal, prefix or fuzzy matcher. Fuzzy matches the
+ * characters in order, taking the first occurrence of each. Like the regex it
+ * replaces, a fuzzy match does not cross a newline.
+ *
+ * @returns the number of ranges filled in, 0 when there is no match.
+ */
+static int matcher_find ( const rofi_int_matcher *m, const char *input, const char *end, const char *from, rofi_range_pair *ranges, gboolean fold )
+{
+    if ( m->num_chars == 0 ) {
+        return 0;
+    }
+    if ( m->method == MM_FUZZY ) {
+        glong      j    = 0;
+        const char *iter = from;
+        while ( iter < end ) {
+            const char *start = iter;
+            gunichar   c      = matcher_next_char ( &iter );
+            if ( matcher_fold ( fold, c ) == m->chars[j] ) {
+                ranges[j].start = start - input;
+                ranges[j].stop  = iter - input;
+                if ( ++j == m->num_chars ) {
+                    return j;
+                }
+            }
+            else if ( c == '\n' ) {
+                j = 0;
+            }
+        }
+        return 0;
+    }
+    const char *match_end = NULL;
+    const char *hit;
+    while ( ( hit = matcher_literal_find ( m, from, end, &match_end, fold ) ) != NULL ) {
+        if ( m->method != MM_PREFIX || matcher_word_boundary ( input, end, hit ) ) {
+            ranges[0].start = hit - input;
+            ranges[0].stop  = match_end - input;
+            return 1;
+        }
+        from = g_utf8_next_char ( hit );
+    }
+    return 0;
+}
+
+/**
+ * @param m The matcher
+ * @param input The string to match
+ * @param end The end of input, input does not need to be terminated.
+ * @param fold If input needs case folding
+ *
+ * @returns TRUE if input matches, the invert flag is not applied.
+ */
+static gboolean matcher_match ( const rofi_int_matcher *m, const char *input, const char *end, gboolean fold )
+{
+    if ( m->pattern == NULL ) {
+        return g_regex_match_full ( m->regex, input, end - input, 0, 0, NULL, NULL );
+    }
+    if ( m->num_chars == 0 ) {
+        return TRUE;
+    }
+    if ( m->method == MM_FUZZY ) {
+        // Only tests if the characters are there in order, no need to track positions.
+        glong j = 0;
+        for ( const char *iter = input; iter < end; ) {
+            gunichar c = matcher_next_char ( &iter );
+            if ( matcher_fold ( fold, c ) == m->chars[j] ) {
+                if ( ++j == m->num_chars ) {
+                    return TRUE;
+                }
+            }
+            else if ( c == '\n' ) {
+                j = 0;
+            }
+        }
+        return FALSE;
+    }
+    rofi_range_pair range;
+    return matcher_find ( m, input, end, input, &range, fold ) > 0;
+}
+
+/**
+ * @param rv The matcher to set up
+ * @param input The token
+ * @param case_sensitive If the match is case sensitive
+ *
+ * Set up the matcher for normal, prefix and fuzzy matching, these do not need a regex.
+ */
+static void create_matcher ( rofi_int_matcher *rv, const char *input, int case_sensitive )
+{
+    rv->method  = config.matching_method;
+    rv->pattern = config.normalize_match ? utf8_helper_simplify_string ( input, -1 ) : g_strdup ( input );
+    rv->chars   = g_utf8_to_ucs4_fast ( rv->pattern, -1, &( rv->num_chars ) );
+    if ( !case_sensitive ) {
+        // Keep the folded pattern, so it can be searched for as bytes in folded text.
+        for ( glong i = 0; i < rv->num_chars; i++ ) {
+            rv->chars[i] = matcher_fold ( TRUE, rv->chars[i] );
+        }
+        g_free ( rv->pattern );
+        rv->pattern = g_ucs4_to_utf8 ( rv->chars, rv->num_chars, NULL, NULL, NULL );
+    }
+    rv->pattern_len = strlen ( rv->pattern );
+}
+
+/**
+ * @param input The token
+ *
+ * @returns TRUE if input has a character that case folds to more than one character (e.g. ß).
+ */
+static gboolean matcher_needs_full_fold ( const char *input )
+{
+    for ( const char *iter = input; iter[0] != '\0'; iter = g_utf8_next_char ( iter ) ) {
+        if ( (guchar) iter[0] < 0x80 ) {
+            continue;
+        }
+        char     *folded = g_utf8_casefold ( iter, g_utf8_next_char ( iter ) - iter );
+        gboolean multi   = g_utf8_strlen ( folded, -1 ) > 1;
+        g_free ( folded );
+        if ( multi ) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 static gchar *fuzzy_to_regex ( const char * input )
 {
     GString *str = g_string_new ( "" );
@@ -178,7 +535,6 @@ static gchar *fuzzy_to_regex ( const char * input )
     g_string_free ( str, FALSE );
     return retv;
 }
-
 static gchar *prefix_regex ( const char * input )
 {
     gchar *r    = g_regex_escape_string ( input, -1 );
@@ -187,51 +543,13 @@ static gchar *prefix_regex ( const char * input )
     return retv;
 }
 
-static char *utf8_helper_simplify_string ( const char *s )
-{
-    gunichar buf2[G_UNICHAR_MAX_DECOMPOSITION_LENGTH] = { 0, };
-    char     buf[6]                                   = { 0, };
-    // Compose the string in maximally composed form.
-    char     * str    = g_malloc0 ( ( g_utf8_strlen ( s, 0 ) * 6 + 2 ) );
-    char     *striter = str;
-    for ( const char *iter = s; iter && *iter; iter = g_utf8_next_char ( iter ) ) {
-        gunichar uc = g_utf8_get_char ( iter );
-        int      l  = 0;
-        gsize    dl = g_unichar_fully_decompose ( uc, FALSE, buf2, G_UNICHAR_MAX_DECOMPOSITION_LENGTH );
-        if ( dl ) {
-            l = g_unichar_to_utf8 ( buf2[0], buf );
-        }
-        else {
-            l = g_unichar_to_utf8 ( uc, buf );
-        }
-        memcpy ( striter, buf, l );
-        striter += l;
-    }
-
-    return str;
-}
-
-// Macro for quickly generating regex for matching.
-static inline GRegex * R ( const char *s, int case_sensitive  )
-{
-    if ( config.normalize_match ) {
-        char   *str = utf8_helper_simplify_string ( s );
-
-        GRegex *r = g_regex_new ( str, G_REGEX_OPTIMIZE | ( ( case_sensitive ) ? 0 : G_REGEX_CASELESS ), 0, NULL );
-
-        g_free ( str );
-        return r;
-    }
-    else {
-        return g_regex_new ( s, G_REGEX_OPTIMIZE | ( ( case_sensitive ) ? 0 : G_REGEX_CASELESS ), 0, NULL );
-    }
-}
-
 static rofi_int_matcher * create_regex ( const char *input, int case_sensitive )
 {
     GRegex           * retv = NULL;
     gchar            *r;
     rofi_int_matcher *rv = g_malloc0 ( sizeof ( rofi_int_matcher ) );
+    // Set for every method, folded strings can only be matched by case insensitive tokens.
+    rv->case_sensitive = case_sensitive;
     if ( input && input[0] == config.matching_negate_char ) {
         rv->invert = 1;
         input++;
@@ -252,24 +570,80 @@ static rofi_int_matcher * create_regex ( const char *input, int case_sensitive )
         }
         break;
     case MM_FUZZY:
-        r    = fuzzy_to_regex ( input );
-        retv = R ( r, case_sensitive );
-        g_free ( r );
-        break;
     case MM_PREFIX:
-        r    = prefix_regex ( input );
-        retv = R ( r, case_sensitive );
-        g_free ( r );
-        break;
     default:
-        r    = g_regex_escape_string ( input, -1 );
+        if ( case_sensitive || !matcher_needs_full_fold ( input ) ) {
+            create_matcher ( rv, input, case_sensitive );
+            break;
+        }
+        // The folded characters would not line up with the text, leave these to the regex.
+        if ( config.matching_method == MM_FUZZY ) {
+            r = fuzzy_to_regex ( input );
+        }
+        else if ( config.matching_method == MM_PREFIX ) {
+            r = prefix_regex ( input );
+        }
+        else {
+            r = g_regex_escape_string ( input, -1 );
+        }
         retv = R ( r, case_sensitive );
         g_free ( r );
         break;
     }
-    rv->regex = retv;
+    rv->regex    = retv;
+    rv->refcount = 1;
+    return rv;
+}
+
+/**
+ * @param input The token
+ * @param case_sensitive If the match is case sensitive
+ *
+ * Get the matcher for the token from the matcher cache, or create it and add it
+ * to the cache. Typing mostly changes the last token, so this avoids compiling
+ * the others again on each key press.
+ *
+ * @returns a reference to the matcher, free with matcher_unref.
+ */
+static rofi_int_matcher *create_regex_cached ( const char *input, int case_sensitive )
+{
+    rofi_int_matcher *rv = NULL;
+    G_LOCK ( matcher_cache );
+    for ( GList *iter = matcher_cache.head; iter != NULL; iter = iter->next ) {
+        matcher_cache_entry *e = (matcher_cache_entry *) iter->data;
+        if ( e->method == (int) config.matching_method && e->case_sensitive == case_sensitive &&
+             e->normalize_match == (int) config.normalize_match && strcmp ( e->token, input ) == 0 ) {
+            // Move to the front.
+            g_queue_unlink ( &matcher_cache, iter );
+            g_queue_push_head_link ( &matcher_cache, iter );
+            rv = e->matcher;
+            g_atomic_int_inc ( &( rv->refcount ) );
+            break;
+        }
+    }
+    G_UNLOCK ( matcher_cache );
+    if ( rv != NULL ) {
+        return rv;
+    }
+
+    rv = create_regex ( input, case_sensitive );
+    matcher_cache_entry *e = g_malloc0 ( sizeof ( matcher_cache_entry ) );
+    e->token           = g_strdup ( input );
+    e->method          = config.matching_method;
+    e->case_sensitive  = case_sensitive;
+    e->normalize_match = config.normalize_match;
+    e->matcher         = rv;
+    g_atomic_int_inc ( &( rv->refcount ) );
+
+    G_LOCK ( matcher_cache );
+    g_queue_push_head ( &matcher_cache, e );
+    while ( g_queue_get_length ( &matcher_cache ) > MATCHER_CACHE_ENTRIES ) {
+        matcher_cache_entry_free ( g_queue_pop_tail ( &matcher_cache ) );
+    }
+    G_UNLOCK ( matcher_cache );
     return rv;
 }
+
 rofi_int_matcher **helper_tokenize ( const char *input, int case_sensitive )
 {
     if ( input == NULL ) {
@@ -284,7 +658,7 @@ rofi_int_matcher **helper_tokenize ( const char *input, int case_sensitive )
     rofi_int_matcher **retv = NULL;
     if ( !config.tokenize ) {
         retv    = g_malloc0 ( sizeof ( rofi_int_matcher* ) * 2 );
-        retv[0] = create_regex ( input, case_sensitive );
+        retv[0] = create_regex_cached ( input, case_sensitive );
         return retv;
     }
 
@@ -299,7 +673,7 @@ rofi_int_matcher **helper_tokenize ( const char *input, int case_sensitive )
     const char * const sep = " ";
     for ( token = strtok_r ( str, sep, &saveptr ); token != NULL; token = strtok_r ( NULL, sep, &saveptr ) ) {
         retv                 = g_realloc ( retv, sizeof ( rofi_int_matcher* ) * ( num_tokens + 2 ) );
-        retv[num_tokens]     = create_regex ( token, case_sensitive );
+        retv[num_tokens]     = create_regex_cached ( token, case_sensitive );
         retv[num_tokens + 1] = NULL;
         num_tokens++;
     }
@@ -424,96 +798,151 @@ int find_arg_char ( const char * const key, char *val )
     return FALSE;
 }
 
-PangoAttrList *helper_token_match_get_pango_attr ( RofiHighlightColorStyle th, rofi_int_matcher**tokens, const char *input, PangoAttrList *retv )
+/**
+ * @param retv The attribute list to add to
+ * @param th The highlight style
+ * @param start Start of the range in bytes
+ * @param end End of the range in bytes
+ *
+ * Add the highlight attributes for one matched range.
+ */
+static void helper_token_match_set_pango_attr_on_style ( PangoAttrList *retv, RofiHighlightColorStyle th, int start, int end )
+{
+    if ( th.style & ROFI_HL_BOLD ) {
+        PangoAttribute *pa = pango_attr_weight_new ( PANGO_WEIGHT_BOLD );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & ROFI_HL_UNDERLINE ) {
+        PangoAttribute *pa = pango_attr_underline_new ( PANGO_UNDERLINE_SINGLE );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & ROFI_HL_STRIKETHROUGH ) {
+        PangoAttribute *pa = pango_attr_strikethrough_new ( TRUE );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & ROFI_HL_SMALL_CAPS ) {
+        PangoAttribute *pa = pango_attr_variant_new ( PANGO_VARIANT_SMALL_CAPS );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & ROFI_HL_ITALIC ) {
+        PangoAttribute *pa = pango_attr_style_new ( PANGO_STYLE_ITALIC );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+    }
+    if ( th.style & ROFI_HL_COLOR ) {
+        PangoAttribute *pa = pango_attr_foreground_new (
+            th.color.red * 65535,
+            th.color.green * 65535,
+            th.color.blue * 65535 );
+        pa->start_index = start;
+        pa->end_index   = end;
+        pango_attr_list_insert ( retv, pa );
+
+        if ( th.color.alpha < 1.0 ) {
+            pa              = pango_attr_foreground_alpha_new ( th.color.alpha * 65535 );
+            pa->start_index = start;
+            pa->end_index   = end;
+            pango_attr_list_insert ( retv, pa );
+        }
+    }
+}
+
+GArray *helper_token_match_get_ranges ( rofi_int_matcher **tokens, const char *input )
 {
     // Disable highlighting for normalize match, not supported atm.
-    if ( config.normalize_match ) {
-        return retv;
+    if ( config.normalize_match || tokens == NULL ) {
+        return NULL;
     }
+    GArray     *retv = g_array_new ( FALSE, FALSE, sizeof ( rofi_range_pair ) );
+    const char *end  = input + strlen ( input );
     // Do a tokenized match.
-    if ( tokens ) {
-        for ( int j = 0; tokens[j]; j++ ) {
-            GMatchInfo *gmi = NULL;
-            if ( tokens[j]->invert ) {
+    for ( int j = 0; tokens[j]; j++ ) {
+        if ( tokens[j]->invert ) {
+            continue;
+        }
+        if ( tokens[j]->pattern != NULL ) {
+            if ( tokens[j]->num_chars == 0 ) {
                 continue;
             }
-            g_regex_match ( tokens[j]->regex, input, G_REGEX_MATCH_PARTIAL, &gmi );
-            while ( g_match_info_matches ( gmi ) ) {
-                int count = g_match_info_get_match_count ( gmi );
-                for ( int index = ( count > 1 ) ? 1 : 0; index < count; index++ ) {
-                    int start, end;
-                    g_match_info_fetch_pos ( gmi, index, &start, &end );
-                    if ( th.style & ROFI_HL_BOLD ) {
-                        PangoAttribute *pa = pango_attr_weight_new ( PANGO_WEIGHT_BOLD );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & ROFI_HL_UNDERLINE ) {
-                        PangoAttribute *pa = pango_attr_underline_new ( PANGO_UNDERLINE_SINGLE );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & ROFI_HL_STRIKETHROUGH ) {
-                        PangoAttribute *pa = pango_attr_strikethrough_new ( TRUE );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & ROFI_HL_SMALL_CAPS ) {
-                        PangoAttribute *pa = pango_attr_variant_new ( PANGO_VARIANT_SMALL_CAPS );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & ROFI_HL_ITALIC ) {
-                        PangoAttribute *pa = pango_attr_style_new ( PANGO_STYLE_ITALIC );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-                    }
-                    if ( th.style & ROFI_HL_COLOR ) {
-                        PangoAttribute *pa = pango_attr_foreground_new (
-                            th.color.red * 65535,
-                            th.color.green * 65535,
-                            th.color.blue * 65535 );
-                        pa->start_index = start;
-                        pa->end_index   = end;
-                        pango_attr_list_insert ( retv, pa );
-
-                        if ( th.color.alpha < 1.0 ) {
-                            pa              = pango_attr_foreground_alpha_new ( th.color.alpha * 65535 );
-                            pa->start_index = start;
-                            pa->end_index   = end;
-                            pango_attr_list_insert ( retv, pa );
-                        }
-                    }
-                }
-                g_match_info_next ( gmi, NULL );
+            rofi_range_pair *ranges = g_malloc0_n ( tokens[j]->num_chars, sizeof ( rofi_range_pair ) );
+            const char      *from   = input;
+            int             count;
+            while ( ( count = matcher_find ( tokens[j], input, end, from, ranges, !tokens[j]->case_sensitive ) ) > 0 ) {
+                g_array_append_vals ( retv, ranges, count );
+                from = input + ranges[count - 1].stop;
+            }
+            g_free ( ranges );
+            continue;
+        }
+        GMatchInfo *gmi = NULL;
+        g_regex_match ( tokens[j]->regex, input, G_REGEX_MATCH_PARTIAL, &gmi );
+        while ( g_match_info_matches ( gmi ) ) {
+            int count = g_match_info_get_match_count ( gmi );
+            for ( int index = ( count > 1 ) ? 1 : 0; index < count; index++ ) {
+                rofi_range_pair range;
+                g_match_info_fetch_pos ( gmi, index, &( range.start ), &( range.stop ) );
+                g_array_append_val ( retv, range );
             }
-            g_match_info_free ( gmi );
+            g_match_info_next ( gmi, NULL );
         }
+        g_match_info_free ( gmi );
+    }
+    return retv;
+}
+
+PangoAttrList *helper_token_match_set_pango_attr_ranges ( RofiHighlightColorStyle th, const GArray *ranges, PangoAttrList *retv )
+{
+    for ( guint i = 0; ranges != NULL && i < ranges->len; i++ ) {
+        const rofi_range_pair *range = &g_array_index ( ranges, rofi_range_pair, i );
+        helper_token_match_set_pango_attr_on_style ( retv, th, range->start, range->stop );
+    }
+    return retv;
+}
+
+PangoAttrList *helper_token_match_get_pango_attr ( RofiHighlightColorStyle th, rofi_int_matcher**tokens, const char *input, PangoAttrList *retv )
+{
+    GArray *ranges = helper_token_match_get_ranges ( tokens, input );
+    if ( ranges != NULL ) {
+        helper_token_match_set_pango_attr_ranges ( th, ranges, retv );
+        g_array_free ( ranges, TRUE );
     }
     return retv;
 }
 
 int helper_token_match ( rofi_int_matcher* const *tokens, const char *input )
+{
+    return helper_token_match_len ( tokens, input, -1 );
+}
+
+int helper_token_match_len ( rofi_int_matcher* const *tokens, const char *input, gssize length )
 {
     int match = TRUE;
     // Do a tokenized match.
     if ( tokens ) {
+        if ( length < 0 ) {
+            length = strlen ( input );
+        }
         if ( config.normalize_match ) {
-            char *r = utf8_helper_simplify_string ( input );
+            char       *r  = utf8_helper_simplify_string ( input, length );
+            const char *re = r + strlen ( r );
             for ( int j = 0; match && tokens[j]; j++ ) {
-                match  = g_regex_match ( tokens[j]->regex, r, 0, NULL );
+                match  = matcher_match ( tokens[j], r, re, !tokens[j]->case_sensitive );
                 match ^= tokens[j]->invert;
             }
             g_free ( r );
         }
         else {
             for ( int j = 0; match && tokens[j]; j++ ) {
-                match  = g_regex_match ( tokens[j]->regex, input, 0, NULL );
+                match  = matcher_match ( tokens[j], input, input + length, !tokens[j]->case_sensitive );
                 match ^= tokens[j]->invert;
             }
         }
@@ -521,6 +950,417 @@ int helper_token_match ( rofi_int_matcher* const *tokens, const char *input )
     return match;
 }
 
+/** Size of the chunks the normalized and folded strings are allocated from. */
+#define MATCH_CACHE_CHUNK_SIZE    65536
+
+/**
+ * Cache holding the strings of a mode in the form they are matched.
+ * Only strings that are normalized or case folded are copied, the others are
+ * referred to where the mode keeps them.
+ */
+struct _RofiMatchCache
+{
+    /** The strings, handed out as string table. */
+    RofiStringTable table;
+    /** The normalized and folded strings. (NULL when the strings are used as they are) */
+    GStringChunk    *strings;
+    /** Buffer the string is converted in before it is stored. */
+    GString         *scratch;
+    /** Number of entries allocated. */
+    unsigned int    size;
+};
+
+RofiMatchCache *helper_match_cache_new ( void )
+{
+    RofiMatchCache *cache = g_malloc0 ( sizeof ( RofiMatchCache ) );
+    cache->table.normalize = config.normalize_match;
+    cache->table.folded    = !config.case_sensitive;
+    if ( cache->table.normalize || cache->table.folded ) {
+        cache->strings = g_string_chunk_new ( MATCH_CACHE_CHUNK_SIZE );
+        cache->scratch = g_string_sized_new ( 256 );
+    }
+    return cache;
+}
+
+void helper_match_cache_free ( RofiMatchCache *cache )
+{
+    if ( cache == NULL ) {
+        return;
+    }
+    if ( cache->strings != NULL ) {
+        g_string_chunk_free ( cache->strings );
+        g_string_free ( cache->scratch, TRUE );
+    }
+    g_free ( cache->table.strings );
+    g_free ( cache->table.lengths );
+    g_free ( cache );
+}
+
+void helper_match_cache_add ( RofiMatchCache *cache, const char *str, gssize length )
+{
+    if ( cache == NULL ) {
+        return;
+    }
+    RofiStringTable *table = &( cache->table );
+    if ( table->length == cache->size ) {
+        cache->size    = MAX ( cache->size * 2, 512 );
+        table->strings = g_realloc_n ( table->strings, cache->size, sizeof ( char * ) );
+        table->lengths = g_realloc_n ( table->lengths, cache->size, sizeof ( unsigned int ) );
+    }
+    if ( str != NULL && length < 0 ) {
+        length = strlen ( str );
+    }
+    if ( str == NULL || cache->strings == NULL ) {
+        // Used as is.
+        table->strings[table->length] = str;
+        table->lengths[table->length] = ( str != NULL ) ? length : 0;
+        table->length++;
+        return;
+    }
+    GString *scratch = cache->scratch;
+    g_string_truncate ( scratch, 0 );
+    for ( const char *iter = str; iter < str + length; ) {
+        gunichar c = matcher_next_char ( &iter );
+        if ( table->normalize ) {
+            c = utf8_helper_simplify_char ( c );
+        }
+        g_string_append_unichar ( scratch, matcher_fold ( table->folded, c ) );
+    }
+    table->strings[table->length] = g_string_chunk_insert_len ( cache->strings, scratch->str, scratch->len );
+    table->lengths[table->length] = scratch->len;
+    table->length++;
+}
+
+const char *helper_match_cache_get ( const RofiMatchCache *cache, unsigned int index )
+{
+    if ( cache == NULL || index >= cache->table.length ) {
+        return NULL;
+    }
+    return cache->table.strings[index];
+}
+
+const RofiStringTable *helper_match_cache_get_table ( const RofiMatchCache *cache )
+{
+    if ( cache == NULL ) {
+        return NULL;
+    }
+    return &( cache->table );
+}
+
+gboolean helper_match_cache_usable ( const RofiMatchCache *cache, rofi_int_matcher * const *tokens, unsigned int index )
+{
+    if ( cache == NULL || index >= cache->table.length ) {
+        return FALSE;
+    }
+    return helper_string_table_usable ( &( cache->table ), tokens );
+}
+
+int helper_match_cache_token_match ( const RofiMatchCache *cache, rofi_int_matcher * const *tokens, unsigned int index )
+{
+    if ( cache == NULL ) {
+        return FALSE;
+    }
+    return helper_string_table_token_match ( &( cache->table ), tokens, index );
+}
+
+gboolean helper_string_table_usable ( const RofiStringTable *table, rofi_int_matcher * const *tokens )
+{
+    if ( table == NULL || table->normalize != (gboolean) config.normalize_match ) {
+        return FALSE;
+    }
+    // Case sensitive tokens cannot be matched against folded strings.
+    for ( int j = 0; table->folded && tokens && tokens[j]; j++ ) {
+        if ( tokens[j]->case_sensitive ) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+int helper_string_table_token_match ( const RofiStringTable *table, rofi_int_matcher * const *tokens, unsigned int index )
+{
+    if ( index >= table->length || table->strings[index] == NULL ) {
+        return FALSE;
+    }
+    const char *input = table->strings[index];
+    const char *end   = input + table->lengths[index];
+    int        match  = TRUE;
+    for ( int j = 0; match && tokens && tokens[j]; j++ ) {
+        match  = matcher_match ( tokens[j], input, end, !tokens[j]->case_sensitive && !table->folded );
+        match ^= tokens[j]->invert;
+    }
+    return match;
+}
+
+/** Number of distinct trigrams of 7 bit characters. */
+#define TRIGRAM_KEYS    ( 1 << 21 )
+
+/**
+ * Trigram index over the strings of a mode.
+ *
+ * The strings are indexed in their normalized and case folded form, the most general form
+ * they can be matched in, so a literal token can only match a row that has all the
+ * (ASCII) trigrams of the token. Each trigram has a posting list of the rows holding it,
+ * stored as varint encoded deltas in one buffer.
+ */
+struct _RofiTrigramIndex
+{
+    /** Offset of the posting list of each trigram in postings, TRIGRAM_KEYS + 1 entries. */
+    guint32      *offsets;
+    /** The posting lists. */
+    guchar       *postings;
+    /** Number of rows indexed. */
+    unsigned int length;
+};
+
+/**
+ * @param c The character
+ *
+ * @returns the character in the form it is indexed.
+ */
+static inline gunichar trigram_index_fold ( gunichar c )
+{
+    if ( c >= 0x80 ) {
+        c = utf8_helper_simplify_char ( c );
+    }
+    return matcher_fold ( TRUE, c );
+}
+
+/**
+ * @param str The string
+ * @param length The length of str
+ * @param keys Array to store the trigram keys in (at least length entries)
+ *
+ * @returns the number of trigrams stored in keys.
+ */
+static unsigned int trigram_index_keys ( const char *str, gsize length, guint32 *keys )
+{
+    unsigned int n   = 0;
+    unsigned int run = 0;
+    guint32      key = 0;
+    for ( const char *iter = str; iter < str + length; ) {
+        gunichar c = trigram_index_fold ( matcher_next_char ( &iter ) );
+        if ( c >= 0x80 ) {
+            // Only 7 bit trigrams are indexed.
+            run = 0;
+            continue;
+        }
+        key = ( ( key << 7 ) | c ) & ( TRIGRAM_KEYS - 1 );
+        if ( ++run >= 3 ) {
+            keys[n++] = key;
+        }
+    }
+    return n;
+}
+
+/**
+ * @param delta The value to encode
+ *
+ * @returns the number of bytes needed to encode delta.
+ */
+static inline unsigned int trigram_index_varint_length ( guint32 delta )
+{
+    unsigned int l = 1;
+    while ( delta >= 0x80 ) {
+        delta >>= 7;
+        l++;
+    }
+    return l;
+}
+
+RofiTrigramIndex *helper_trigram_index_new ( unsigned int length, RofiTrigramIndexGetString get_string, gpointer data, const gint *cancel )
+{
+    guint32 *last  = g_malloc0_n ( TRIGRAM_KEYS, sizeof ( guint32 ) );
+    guint64 *sizes = g_malloc0_n ( TRIGRAM_KEYS, sizeof ( guint64 ) );
+    guint32 *keys  = NULL;
+    gsize   nkeys  = 0;
+    guint64 total  = 0;
+
+    // First pass, size the posting lists.
+    for ( unsigned int row = 0; row < length; row++ ) {
+        if ( cancel != NULL && ( row % 4096 ) == 0 && g_atomic_int_get ( cancel ) ) {
+            g_free ( keys );
+            g_free ( sizes );
+            g_free ( last );
+            return NULL;
+        }
+        const char *str;
+        gsize      l = 0;
+        for ( unsigned int field = 0; ( str = get_string ( data, row, field, &l ) ) != NULL; field++ ) {
+            if ( l > nkeys ) {
+                nkeys = MAX ( l, 2 * nkeys );
+                keys  = g_renew ( guint32, keys, nkeys );
+            }
+            unsigned int n = trigram_index_keys ( str, l, keys );
+            for ( unsigned int i = 0; i < n; i++ ) {
+                // Rows are stored one based, so a delta is never 0.
+                if ( last[keys[i]] != row + 1 ) {
+                    sizes[keys[i]] += trigram_index_varint_length ( row + 1 - last[keys[i]] );
+                    last[keys[i]]   = row + 1;
+                }
+            }
+        }
+    }
+    RofiTrigramIndex *index = g_malloc0 ( sizeof ( RofiTrigramIndex ) );
+    index->length  = length;
+    index->offsets = g_malloc_n ( TRIGRAM_KEYS + 1, sizeof ( guint32 ) );
+    for ( guint32 k = 0; k < TRIGRAM_KEYS; k++ ) {
+        index->offsets[k] = (guint32) total;
+        total            += sizes[k];
+    }
+    g_free ( sizes );
+    if ( total > G_MAXUINT32 ) {
+        // Too big to address, matching falls back to checking all rows.
+        g_warning ( "Input too large to index (%" G_GUINT64_FORMAT " bytes of postings)", total );
+        g_free ( index->offsets );
+        g_free ( index );
+        g_free ( keys );
+        g_free ( last );
+        return NULL;
+    }
+    index->offsets[TRIGRAM_KEYS] = (guint32) total;
+    index->postings              = g_malloc ( MAX ( total, 1 ) );
+
+    // Second pass, fill them.
+    guint32 *cursor = g_memdup ( index->offsets, TRIGRAM_KEYS * sizeof ( guint32 ) );
+    memset ( last, 0, TRIGRAM_KEYS * sizeof ( guint32 ) );
+    for ( unsigned int row = 0; row < length; row++ ) {
+        if ( cancel != NULL && ( row % 4096 ) == 0 && g_atomic_int_get ( cancel ) ) {
+            break;
+        }
+        const char *str;
+        gsize      l = 0;
+        for ( unsigned int field = 0; ( str = get_string ( data, row, field, &l ) ) != NULL; field++ ) {
+            unsigned int n = trigram_index_keys ( str, l, keys );
+            for ( unsigned int i = 0; i < n; i++ ) {
+                if ( last[keys[i]] != row + 1 ) {
+                    guint32 delta = row + 1 - last[keys[i]];
+                    guchar  *p    = &( index->postings[cursor[keys[i]]] );
+                    while ( delta >= 0x80 ) {
+                        *( p++ ) = ( delta & 0x7F ) | 0x80;
+                        delta  >>= 7;
+                    }
+                    *( p++ )        = delta;
+                    cursor[keys[i]] = p - index->postings;
+                    last[keys[i]]   = row + 1;
+                }
+            }
+        }
+    }
+    g_free ( cursor );
+    g_free ( keys );
+    g_free ( last );
+    if ( cancel != NULL && g_atomic_int_get ( cancel ) ) {
+        helper_trigram_index_free ( index );
+        return NULL;
+    }
+    return index;
+}
+
+void helper_trigram_index_free ( RofiTrigramIndex *index )
+{
+    if ( index == NULL ) {
+        return;
+    }
+    g_free ( index->offsets );
+    g_free ( index->postings );
+    g_free ( index );
+}
+
+/**
+ * @param iter Position in the posting list, moved to the next entry.
+ * @param row The previous row (one based), updated to the next row.
+ */
+static inline void trigram_index_next ( const guchar **iter, guint32 *row )
+{
+    guint32      delta = 0;
+    unsigned int shift = 0;
+    while ( **iter & 0x80 ) {
+        delta |= ( (guint32) ( *( ( *iter )++ ) & 0x7F ) ) << shift;
+        shift += 7;
+    }
+    delta |= ( (guint32) *( ( *iter )++ ) ) << shift;
+    *row  += delta;
+}
+
+/**
+ * Compare the posting list length of two trigrams.
+ */
+static gint trigram_index_key_sort ( gconstpointer a, gconstpointer b, gpointer data )
+{
+    const guint32 *offsets = (const guint32 *) data;
+    guint32       ka       = *( (const guint32 *) a );
+    guint32       kb       = *( (const guint32 *) b );
+    guint32       la       = offsets[ka + 1] - offsets[ka];
+    guint32       lb       = offsets[kb + 1] - offsets[kb];
+    if ( la != lb ) {
+        return la < lb ? -1 : 1;
+    }
+    return ka < kb ? -1 : ( ka > kb );
+}
+
+unsigned int *helper_trigram_index_candidates ( const RofiTrigramIndex *index, rofi_int_matcher * const *tokens, unsigned int *length )
+{
+    if ( index == NULL || tokens == NULL ) {
+        return NULL;
+    }
+    GArray *keys = g_array_new ( FALSE, FALSE, sizeof ( guint32 ) );
+    for ( int j = 0; tokens[j]; j++ ) {
+        const rofi_int_matcher *m = tokens[j];
+        // Regex, glob and fuzzy tokens have no literal to look up, a negated token rules out nothing.
+        if ( m->regex != NULL || m->invert || m->pattern == NULL ||
+             ( m->method != MM_NORMAL && m->method != MM_PREFIX ) ) {
+            continue;
+        }
+        guint32      *tk = g_malloc_n ( m->pattern_len + 1, sizeof ( guint32 ) );
+        unsigned int n   = trigram_index_keys ( m->pattern, m->pattern_len, tk );
+        g_array_append_vals ( keys, tk, n );
+        g_free ( tk );
+    }
+    if ( keys->len == 0 ) {
+        g_array_free ( keys, TRUE );
+        return NULL;
+    }
+    // Intersect starting with the shortest list, so the candidate set is small from the start.
+    g_array_sort_with_data ( keys, trigram_index_key_sort, index->offsets );
+
+    guint32      k0          = g_array_index ( keys, guint32, 0 );
+    const guchar *iter       = index->postings + index->offsets[k0];
+    const guchar *end        = index->postings + index->offsets[k0 + 1];
+    unsigned int *candidates = g_malloc_n ( ( end - iter ) + 1, sizeof ( unsigned int ) );
+    unsigned int n           = 0;
+    guint32      row         = 0;
+    while ( iter < end ) {
+        trigram_index_next ( &iter, &row );
+        candidates[n++] = row - 1;
+    }
+    for ( guint i = 1; i < keys->len && n > 0; i++ ) {
+        guint32 k = g_array_index ( keys, guint32, i );
+        if ( k == g_array_index ( keys, guint32, i - 1 ) ) {
+            continue;
+        }
+        unsigned int count = 0;
+        iter = index->postings + index->offsets[k];
+        end  = index->postings + index->offsets[k + 1];
+        row  = 0;
+        for ( unsigned int c = 0; c < n && iter < end; ) {
+            if ( row <= candidates[c] ) {
+                trigram_index_next ( &iter, &row );
+            }
+            while ( c < n && candidates[c] < row - 1 ) {
+                c++;
+            }
+            if ( c < n && candidates[c] == row - 1 ) {
+                candidates[count++] = candidates[c++];
+            }
+        }
+        n = count;
+    }
+    g_array_free ( keys, TRUE );
+    *length = n;
+    return candidates;
+}
+
 int execute_generator ( const char * cmd )
 {
     char **args = NULL;
@@ -609,7 +1449,7 @@ gboolean helper_validate_font ( PangoFontDescription *pfd, const char *font )
  *
  * This functions exits the program with 1 when it finds an invalid configuration.
  */
-int config_sanity_check ( void )
+int config_sanity_check ( gboolean check_display )
 {
     int     found_error = FALSE;
     GString *msg        = g_string_new (
@@ -669,7 +1509,7 @@ int config_sanity_check ( void )
     }
 
     // Check size
-    {
+    if ( check_display ) {
         workarea mon;
         if ( !monitor_active ( &mon ) ) {
             const char *name = config.monitor;
@@ -742,42 +1582,227 @@ char *rofi_expand_path ( const char *input )
     return retv;
 }
 
-/** Return the minimum value of a,b,c */
-#define MIN3( a, b, c )    ( ( a ) < ( b ) ? ( ( a ) < ( c ) ? ( a ) : ( c ) ) : ( ( b ) < ( c ) ? ( b ) : ( c ) ) )
+/**
+ * The pattern of #levenshtein, decoded and case folded once for all the rows it is compared to.
+ */
+typedef struct
+{
+    /** The pattern as passed by the caller. */
+    char     *needle;
+    /** Length of needle in bytes. */
+    gsize    needle_bytes;
+    /** Length of the pattern in characters. */
+    glong    length;
+    /** Case sensitivity the pattern was folded for. */
+    gboolean case_sensitive;
+    /** Number of 64 bit words needed to hold a bit for each character. */
+    glong    blocks;
+    /** Match vectors for the ASCII characters, blocks words per character. */
+    guint64  *ascii;
+    /** Other distinct characters in the pattern. */
+    gunichar *chars;
+    /** Number of entries in chars. */
+    glong    num_chars;
+    /** Match vectors for chars, blocks words per character. */
+    guint64  *masks;
+    /** Match vector for characters not in the pattern. */
+    guint64  *none;
+    /** Positive vertical deltas, blocks words. */
+    guint64  *pv;
+    /** Negative vertical deltas, blocks words. */
+    guint64  *mv;
+} LevenshteinPattern;
+
+static void levenshtein_pattern_free ( gpointer data )
+{
+    LevenshteinPattern *lp = (LevenshteinPattern *) data;
+    if ( lp == NULL ) {
+        return;
+    }
+    g_free ( lp->needle );
+    g_free ( lp->ascii );
+    g_free ( lp->chars );
+    g_free ( lp->masks );
+    g_free ( lp->none );
+    g_free ( lp->pv );
+    g_free ( lp->mv );
+    g_free ( lp );
+}
+
+/** The last pattern used by #levenshtein in this thread. */
+static GPrivate levenshtein_pattern_key = G_PRIVATE_INIT ( levenshtein_pattern_free );
+
+/**
+ * @param needle The pattern
+ * @param needlelen The length of the pattern in characters
+ *
+ * Get the decoded pattern, the rows of one filter run all share the same pattern so this is only
+ * built again when the input or case sensitivity changed.
+ *
+ * @returns the decoded pattern, owned by the calling thread.
+ */
+static const LevenshteinPattern *levenshtein_pattern_get ( const char *needle, const glong needlelen )
+{
+    LevenshteinPattern *lp    = g_private_get ( &levenshtein_pattern_key );
+    gsize              nbytes = g_utf8_offset_to_pointer ( needle, needlelen ) - needle;
+    if ( lp != NULL && lp->length == needlelen && lp->case_sensitive == config.case_sensitive &&
+         lp->needle_bytes == nbytes && memcmp ( lp->needle, needle, nbytes ) == 0 ) {
+        return lp;
+    }
+
+    lp                 = g_malloc0 ( sizeof ( LevenshteinPattern ) );
+    lp->needle         = g_strndup ( needle, nbytes );
+    lp->needle_bytes   = nbytes;
+    lp->length         = needlelen;
+    lp->case_sensitive = config.case_sensitive;
+    lp->blocks         = ( needlelen + 63 ) / 64;
+    lp->ascii          = g_malloc0_n ( 0x80 * lp->blocks, sizeof ( guint64 ) );
+    lp->chars          = g_malloc0_n ( needlelen, sizeof ( gunichar ) );
+    lp->masks          = g_malloc0_n ( needlelen * lp->blocks, sizeof ( guint64 ) );
+    lp->none           = g_malloc0_n ( lp->blocks, sizeof ( guint64 ) );
+    lp->pv             = g_malloc0_n ( lp->blocks, sizeof ( guint64 ) );
+    lp->mv             = g_malloc0_n ( lp->blocks, sizeof ( guint64 ) );
+
+    const char *iter = needle;
+    for ( glong y = 0; y < needlelen; y++ ) {
+        gunichar c   = matcher_fold ( !config.case_sensitive, matcher_next_char ( &iter ) );
+        guint64  bit = G_GUINT64_CONSTANT ( 1 ) << ( y % 64 );
+        if ( c < 0x80 ) {
+            lp->ascii[c * lp->blocks + y / 64] |= bit;
+            continue;
+        }
+        glong i = 0;
+        while ( i < lp->num_chars && lp->chars[i] != c ) {
+            i++;
+        }
+        if ( i == lp->num_chars ) {
+            lp->chars[lp->num_chars++] = c;
+        }
+        lp->masks[i * lp->blocks + y / 64] |= bit;
+    }
+    // Replaces (and frees) the pattern of the previous run.
+    g_private_replace ( &levenshtein_pattern_key, lp );
+    return lp;
+}
 
+/**
+ * @param lp The decoded pattern
+ * @param c The (folded) character
+ *
+ * @returns the match vector of c, with a bit set for each position it has in the pattern.
+ */
+static inline const guint64 *levenshtein_pattern_eq ( const LevenshteinPattern *lp, gunichar c )
+{
+    if ( c < 0x80 ) {
+        return &( lp->ascii[c * lp->blocks] );
+    }
+    for ( glong i = 0; i < lp->num_chars; i++ ) {
+        if ( lp->chars[i] == c ) {
+            return &( lp->masks[i * lp->blocks] );
+        }
+    }
+    return lp->none;
+}
+
+/**
+ * @param pv The positive vertical deltas of the block
+ * @param mv The negative vertical deltas of the block
+ * @param eq The match vector of the block
+ * @param hin The horizontal delta entering the top of the block
+ * @param high The bit of the last row in the block
+ *
+ * Advance one 64 row block of the edit distance matrix by one column.
+ *
+ * @returns the horizontal delta leaving the bottom of the block.
+ */
+static inline int levenshtein_advance_block ( guint64 *pv, guint64 *mv, guint64 eq, int hin, guint64 high )
+{
+    guint64 xv = eq | *mv;
+    if ( hin < 0 ) {
+        eq |= 1;
+    }
+    guint64 xh   = ( ( ( eq & *pv ) + *pv ) ^ *pv ) | eq;
+    guint64 ph   = *mv | ~( xh | *pv );
+    guint64 mh   = *pv & xh;
+    int     hout = 0;
+    if ( ph & high ) {
+        hout = 1;
+    }
+    else if ( mh & high ) {
+        hout = -1;
+    }
+    ph <<= 1;
+    mh <<= 1;
+    if ( hin < 0 ) {
+        mh |= 1;
+    }
+    else if ( hin > 0 ) {
+        ph |= 1;
+    }
+    *pv = mh | ~( xv | ph );
+    *mv = ph & xv;
+    return hout;
+}
+
+/*
+ * Bit-parallel edit distance (Myers 1999, in the global form of Hyyrö 2001).
+ * Each column of the matrix is kept as vertical deltas, one bit per pattern character, so a
+ * haystack character costs a handful of word operations per 64 pattern characters.
+ */
 unsigned int levenshtein ( const char *needle, const glong needlelen, const char *haystack, const glong haystacklen )
 {
     if ( needlelen == G_MAXLONG ) {
         // String to long, we cannot handle this.
         return UINT_MAX;
     }
-    unsigned int column[needlelen + 1];
-    for ( glong y = 0; y < needlelen; y++ ) {
-        column[y] = y;
-    }
-    // Removed out of the loop, otherwise static code analyzers think it is unset.. silly but true.
-    // old loop: for ( glong y = 0; y <= needlelen; y++)
-    column[needlelen] = needlelen;
-    for ( glong x = 1; x <= haystacklen; x++ ) {
-        const char *needles = needle;
-        column[0] = x;
-        gunichar   haystackc = g_utf8_get_char ( haystack );
-        if ( !config.case_sensitive ) {
-            haystackc = g_unichar_tolower ( haystackc );
-        }
-        for ( glong y = 1, lastdiag = x - 1; y <= needlelen; y++ ) {
-            gunichar needlec = g_utf8_get_char ( needles );
-            if ( !config.case_sensitive ) {
-                needlec = g_unichar_tolower ( needlec );
+    if ( needlelen <= 0 ) {
+        return haystacklen;
+    }
+    const LevenshteinPattern *lp   = levenshtein_pattern_get ( needle, needlelen );
+    glong                    score = needlelen;
+    glong                    last  = lp->blocks - 1;
+    guint64                  high  = G_GUINT64_CONSTANT ( 1 ) << ( ( needlelen - 1 ) % 64 );
+    const char               *iter = haystack;
+    gboolean                 fold  = !config.case_sensitive;
+    if ( lp->blocks == 1 ) {
+        guint64 pv = ~G_GUINT64_CONSTANT ( 0 );
+        guint64 mv = 0;
+        for ( glong x = 0; x < haystacklen; x++ ) {
+            guint64 eq = levenshtein_pattern_eq ( lp, matcher_fold ( fold, matcher_next_char ( &iter ) ) )[0];
+            guint64 xv = eq | mv;
+            guint64 xh = ( ( ( eq & pv ) + pv ) ^ pv ) | eq;
+            guint64 ph = mv | ~( xh | pv );
+            guint64 mh = pv & xh;
+            if ( ph & high ) {
+                score++;
             }
-            unsigned int olddiag = column[y];
-            column[y] = MIN3 ( column[y] + 1, column[y - 1] + 1, lastdiag + ( needlec == haystackc ? 0 : 1 ) );
-            lastdiag  = olddiag;
-            needles   = g_utf8_next_char ( needles );
+            else if ( mh & high ) {
+                score--;
+            }
+            // The top row of the matrix grows by one for each column.
+            ph = ( ph << 1 ) | 1;
+            mh = mh << 1;
+            pv = mh | ~( xv | ph );
+            mv = ph & xv;
+        }
+        return score;
+    }
+
+    guint64 *pv = lp->pv;
+    guint64 *mv = lp->mv;
+    for ( glong b = 0; b < lp->blocks; b++ ) {
+        pv[b] = ~G_GUINT64_CONSTANT ( 0 );
+        mv[b] = 0;
+    }
+    for ( glong x = 0; x < haystacklen; x++ ) {
+        const guint64 *eq = levenshtein_pattern_eq ( lp, matcher_fold ( fold, matcher_next_char ( &iter ) ) );
+        int           h   = 1;
+        for ( glong b = 0; b < last; b++ ) {
+            h = levenshtein_advance_block ( &( pv[b] ), &( mv[b] ), eq[b], h, G_GUINT64_CONSTANT ( 1 ) << 63 );
         }
-        haystack = g_utf8_next_char ( haystack );
+        score += levenshtein_advance_block ( &( pv[last] ), &( mv[last] ), eq[last], h, high );
     }
-    return column[needlelen];
+    return score;
 }
 
 char * rofi_latin_to_utf8_strdup ( const char *input, gssize length )
@@ -829,8 +1854,6 @@ char * rofi_force_utf8 ( const gchar *data, ssize_t length )
  * FZF like scorer
  */
 
-/** Max length of input to score. */
-#define FUZZY_SCORER_MAX_LENGTH         256
 /** minimum score */
 #define MIN_SCORE                       ( INT_MIN / 2 )
 /** Leading gap score */
@@ -907,48 +1930,156 @@ static int rofi_scorer_get_score_for ( enum CharClass prev, enum CharClass curr
     return 0;
 }
 
+/**
+ * Scratch space of #rofi_scorer_fuzzy_evaluate, kept per thread and grown as needed.
+ */
+typedef struct
+{
+    /** The non-space characters of the pattern, folded when matching case insensitive. */
+    gunichar *pattern;
+    /** If the pattern character starts a word. */
+    gboolean *pattern_start;
+    /** Allocated length of pattern and pattern_start. */
+    glong    pattern_size;
+    /** The (folded) characters of the scored window of the string. */
+    gunichar *chars;
+    /** score for each position */
+    int      *score;
+    /** dp[i]: maximum value by aligning pattern[0..pi] to str[0..si] */
+    int      *dp;
+    /** Allocated length of chars, score and dp. */
+    glong    size;
+} FuzzyScorerScratch;
+
+static void rofi_scorer_scratch_free ( gpointer data )
+{
+    FuzzyScorerScratch *s = (FuzzyScorerScratch *) data;
+    if ( s == NULL ) {
+        return;
+    }
+    g_free ( s->pattern );
+    g_free ( s->pattern_start );
+    g_free ( s->chars );
+    g_free ( s->score );
+    g_free ( s->dp );
+    g_free ( s );
+}
+
+/** Scratch space of the scorer in this thread. */
+static GPrivate rofi_scorer_scratch_key = G_PRIVATE_INIT ( rofi_scorer_scratch_free );
+
+/**
+ * @param plen The length of the pattern.
+ * @param slen The length of the scored window.
+ *
+ * @returns the scratch space of this thread, large enough for plen and slen.
+ */
+static FuzzyScorerScratch *rofi_scorer_scratch_get ( glong plen, glong slen )
+{
+    FuzzyScorerScratch *s = g_private_get ( &rofi_scorer_scratch_key );
+    if ( s == NULL ) {
+        s = g_malloc0 ( sizeof ( FuzzyScorerScratch ) );
+        g_private_set ( &rofi_scorer_scratch_key, s );
+    }
+    if ( plen > s->pattern_size ) {
+        s->pattern_size  = MAX ( plen, 2 * s->pattern_size );
+        s->pattern       = g_renew ( gunichar, s->pattern, s->pattern_size );
+        s->pattern_start = g_renew ( gboolean, s->pattern_start, s->pattern_size );
+    }
+    if ( slen > s->size ) {
+        s->size  = MAX ( slen, 2 * s->size );
+        s->chars = g_renew ( gunichar, s->chars, s->size );
+        s->score = g_renew ( int, s->score, s->size );
+        s->dp    = g_renew ( int, s->dp, s->size );
+    }
+    return s;
+}
+
 int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *str, glong slen )
 {
-    if ( slen > FUZZY_SCORER_MAX_LENGTH ) {
-        return -MIN_SCORE;
+    gboolean fold   = !config.case_sensitive;
+    glong    window = slen;
+    if ( config.sorting_max_length > 0 ) {
+        window = MIN ( slen, (glong) config.sorting_max_length );
     }
-    glong    pi, si;
-    // whether we are aligning the first character of pattern
-    gboolean pfirst = TRUE;
+    FuzzyScorerScratch *s  = rofi_scorer_scratch_get ( plen, window );
+    glong              np  = 0, pi, si;
+
+    // Decode the pattern once, dropping the spaces that separate its words.
     // whether the start of a word in pattern
-    gboolean pstart = TRUE;
-    // score for each position
-    int      *score = g_malloc_n ( slen, sizeof ( int ) );
-    // dp[i]: maximum value by aligning pattern[0..pi] to str[0..si]
-    int      *dp = g_malloc_n ( slen, sizeof ( int ) );
-    // uleft: value of the upper left cell; ulefts: maximum value of uleft and cells on the left. The arbitrary initial
-    // values suppress warnings.
-    int            uleft = 0, ulefts = 0, left, lefts;
-    const gchar    *pit = pattern, *sit;
-    enum CharClass prev = NON_WORD;
-    for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
-        enum CharClass cur = rofi_scorer_get_character_class ( g_utf8_get_char ( sit ) );
-        score[si] = rofi_scorer_get_score_for ( prev, cur );
-        prev      = cur;
-        dp[si]    = MIN_SCORE;
-    }
-    for ( pi = 0; pi < plen; pi++, pit = g_utf8_next_char ( pit ) ) {
-        gunichar pc = g_utf8_get_char ( pit ), sc;
+    gboolean    pstart = TRUE;
+    const gchar *pit   = pattern;
+    for ( pi = 0; pi < plen; pi++ ) {
+        gunichar pc = matcher_next_char ( &pit );
         if ( g_unichar_isspace ( pc ) ) {
             pstart = TRUE;
             continue;
         }
-        lefts = MIN_SCORE;
-        for ( si = 0, sit = str; si < slen; si++, sit = g_utf8_next_char ( sit ) ) {
+        s->pattern[np]       = matcher_fold ( fold, pc );
+        s->pattern_start[np] = pstart;
+        pstart               = FALSE;
+        np++;
+    }
+    if ( np == 0 ) {
+        return -MIN_SCORE;
+    }
+
+    // Skip to the first character that can align with the pattern, nothing before it contributes to the score.
+    const gchar    *sit = str;
+    enum CharClass prev = NON_WORD;
+    glong          first;
+    for ( first = 0; first < slen; first++ ) {
+        gunichar sc = matcher_next_char ( &sit );
+        if ( matcher_fold ( fold, sc ) == s->pattern[0] ) {
+            s->chars[0] = s->pattern[0];
+            s->score[0] = rofi_scorer_get_score_for ( prev, rofi_scorer_get_character_class ( sc ) );
+            prev        = rofi_scorer_get_character_class ( sc );
+            break;
+        }
+        prev = rofi_scorer_get_character_class ( sc );
+    }
+    if ( first == slen ) {
+        return -MIN_SCORE;
+    }
+    // Decode and classify the window once, checking pattern is a subsequence of it on the way.
+    glong length = MIN ( window, slen - first );
+    glong found  = 1;
+    for ( si = 1; si < length; si++ ) {
+        gunichar       sc  = matcher_next_char ( &sit );
+        enum CharClass cur = rofi_scorer_get_character_class ( sc );
+        s->chars[si] = matcher_fold ( fold, sc );
+        s->score[si] = rofi_scorer_get_score_for ( prev, cur );
+        prev         = cur;
+        if ( found < np && s->chars[si] == s->pattern[found] ) {
+            found++;
+        }
+    }
+    if ( found < np ) {
+        // Not a subsequence (of the window): no alignment to score.
+        return -MIN_SCORE;
+    }
+
+    // whether we are aligning the first character of pattern
+    gboolean pfirst = TRUE;
+    int      *score = s->score;
+    int      *dp    = s->dp;
+    // uleft: value of the upper left cell; ulefts: maximum value of uleft and cells on the left.
+    int uleft, ulefts, left, lefts;
+    for ( si = 0; si < length; si++ ) {
+        dp[si] = MIN_SCORE;
+    }
+    for ( pi = 0; pi < np; pi++ ) {
+        gunichar pc = s->pattern[pi];
+        int      m  = s->pattern_start[pi] ? PATTERN_START_MULTIPLIER : PATTERN_NON_START_MULTIPLIER;
+        // Nothing is left of the first column, do not carry over the end of the previous row.
+        lefts = uleft = ulefts = MIN_SCORE;
+        for ( si = 0; si < length; si++ ) {
             left  = dp[si];
             lefts = MAX ( lefts + GAP_SCORE, left );
-            sc    = g_utf8_get_char ( sit );
-            if ( config.case_sensitive
-                 ? pc == sc
-                 : g_unichar_tolower ( pc ) == g_unichar_tolower ( sc ) ) {
-                int t = score[si] * ( pstart ? PATTERN_START_MULTIPLIER : PATTERN_NON_START_MULTIPLIER );
+            if ( pc == s->chars[si] ) {
+                int t = score[si] * m;
                 dp[si] = pfirst
-                         ? LEADING_GAP_SCORE * si + t
+                         ? LEADING_GAP_SCORE * ( first + si ) + t
                          : MAX ( uleft + CONSECUTIVE_SCORE, ulefts + t );
             }
             else {
@@ -957,14 +2088,12 @@ int rofi_scorer_fuzzy_evaluate ( const char *pattern, glong plen, const char *st
             uleft  = left;
             ulefts = lefts;
         }
-        pfirst = pstart = FALSE;
+        pfirst = FALSE;
     }
     lefts = MIN_SCORE;
-    for ( si = 0; si < slen; si++ ) {
+    for ( si = 0; si < length; si++ ) {
         lefts = MAX ( lefts + GAP_SCORE, dp[si] );
     }
-    g_free ( score );
-    g_free ( dp );
     return -lefts;
 }
 
@@ -94,6 +94,15 @@ char * mode_get_completion ( const Mode *mode, unsigned int selected_line )
     }
 }
 
+const char * mode_peek_completion ( const Mode *mode, unsigned int selected_line, glong *length )
+{
+    g_assert ( mode != NULL );
+    if ( mode->_peek_completion != NULL ) {
+        return mode->_peek_completion ( mode, selected_line, length );
+    }
+    return NULL;
+}
+
 ModeMode mode_result ( Mode *mode, int menu_retv, char **input, unsigned int selected_line )
 {
     if ( menu_retv & MENU_NEXT ) {
@@ -120,6 +129,41 @@ int mode_token_match ( const Mode *mode, rofi_int_matcher **tokens, unsigned int
     return mode->_token_match ( mode, tokens, selected_line );
 }
 
+void mode_token_match_batch ( const Mode *mode, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count )
+{
+    g_assert ( mode != NULL );
+    if ( mode->_token_match_batch != NULL ) {
+        mode->_token_match_batch ( mode, tokens, start, stop, out, count );
+        return;
+    }
+    g_assert ( mode->_token_match != NULL );
+    unsigned int matched = 0;
+    for ( unsigned int i = start; i < stop; i++ ) {
+        if ( mode->_token_match ( mode, tokens, i ) ) {
+            out[matched++] = i;
+        }
+    }
+    *count = matched;
+}
+
+unsigned int * mode_token_candidates ( const Mode *mode, rofi_int_matcher **tokens, unsigned int *length )
+{
+    g_assert ( mode != NULL );
+    if ( mode->_token_candidates != NULL ) {
+        return mode->_token_candidates ( mode, tokens, length );
+    }
+    return NULL;
+}
+
+const RofiStringTable * mode_get_string_table ( const Mode *mode )
+{
+    g_assert ( mode != NULL );
+    if ( mode->_get_string_table != NULL ) {
+        return mode->_get_string_table ( mode );
+    }
+    return NULL;
+}
+
 const char *mode_get_name ( const Mode *mode )
 {
     g_assert ( mode != NULL );
@@ -477,6 +477,7 @@ static void cleanup ()
     TIMINGS_STOP ();
     rofi_collect_modi_destroy ( );
     rofi_icon_fetcher_destroy ( );
+    helper_tokenize_cache_clear ( );
 
     if ( rofi_configuration ) {
         rofi_theme_free ( rofi_configuration );
@@ -715,7 +716,7 @@ static gboolean startup ( G_GNUC_UNUSED gpointer data )
     // Parse the keybindings.
     TICK_N ( "Parse ABE" );
     // Sanity check
-    config_sanity_check ( );
+    config_sanity_check ( TRUE );
     TICK_N ( "Config sanity check" );
 
     if ( list_of_error_msgs != NULL ) {
@@ -841,6 +842,8 @@ int main ( int argc, char *argv[] )
         // Free the basename for dmenu detection.
         g_free ( base_name );
     }
+    // Filter the input to stdout, without a window.
+    gboolean filter_stdout = dmenu_mode && find_arg ( "-filter-stdout" ) >= 0;
     TICK ();
 
     // Create pid file path.
@@ -915,12 +918,14 @@ int main ( int argc, char *argv[] )
     bindings = nk_bindings_new ( 0 );
     TICK_N ( "NK Bindings" );
 
-    if ( !display_setup ( main_loop, bindings ) ) {
-        g_warning ( "Connection has error" );
-        cleanup ();
-        return EXIT_FAILURE;
+    if ( !filter_stdout ) {
+        if ( !display_setup ( main_loop, bindings ) ) {
+            g_warning ( "Connection has error" );
+            cleanup ();
+            return EXIT_FAILURE;
+        }
+        TICK_N ( "Setup Display" );
     }
-    TICK_N ( "Setup Display" );
 
     // Setup keybinding
     setup_abe ();
@@ -1063,6 +1068,21 @@ int main ( int argc, char *argv[] )
         return EXIT_SUCCESS;
     }
 
+    if ( filter_stdout ) {
+        if ( config_sanity_check ( FALSE ) ) {
+            for ( GList *iter = g_list_first ( list_of_error_msgs ); iter != NULL; iter = g_list_next ( iter ) ) {
+                g_warning ( "Error: %s%s%s", color_bold, ( (GString *) iter->data )->str, color_reset );
+            }
+            cleanup ();
+            return EX_DATAERR;
+        }
+        rofi_view_workers_initialize ();
+        TICK_N ( "Workers initialize" );
+        int retv = dmenu_filter_stdout ();
+        cleanup ();
+        return retv;
+    }
+
     unsigned int interval = 1;
     if ( find_arg_uint ( "-record-screenshots", &interval ) ) {
         g_timeout_add ( 1000 / (double) interval, record, NULL );
@@ -79,6 +79,9 @@ void rofi_view_update ( RofiViewState *state, gboolean qr );
 
 static int rofi_view_calculate_height ( RofiViewState *state );
 
+static void rofi_view_filter_cancel ( RofiViewState *state );
+static void rofi_view_filter_cache_clear ( RofiViewState *state );
+
 /** Thread pool used for filtering */
 GThreadPool *tpool = NULL;
 
@@ -166,6 +169,8 @@ static char * get_matching_state ( void )
 
 /**
  * Levenshtein Sorting.
+ * Rows with equal distance keep the order of the entries, so the order does
+ * not depend on how the rows were found.
  */
 static int lev_sort ( const void *p1, const void *p2, void *arg )
 {
@@ -173,7 +178,94 @@ static int lev_sort ( const void *p1, const void *p2, void *arg )
     const int *b         = p2;
     int       *distances = arg;
 
-    return distances[*a] - distances[*b];
+    if ( distances[*a] != distances[*b] ) {
+        return ( distances[*a] < distances[*b] ) ? -1 : 1;
+    }
+    return ( *a > *b ) - ( *a < *b );
+}
+
+static inline void lev_swap ( unsigned int *a, unsigned int *b )
+{
+    unsigned int t = *a;
+    *a = *b;
+    *b = t;
+}
+
+/**
+ * @param lines The rows to partition
+ * @param length The number of rows
+ * @param k The number of best rows to move to the front
+ * @param distances The distance of each entry
+ *
+ * Partition the rows so the k best rows (in lev_sort order) are in front, in no
+ * particular order. Quickselect with a median of three pivot, linear on average.
+ */
+static void lev_select ( unsigned int *lines, unsigned int length, unsigned int k, int *distances )
+{
+    long lo = 0, hi = (long) length - 1;
+    while ( lo < hi ) {
+        long mid = lo + ( hi - lo ) / 2;
+        // Median of three, ends up in lines[mid].
+        if ( lev_sort ( &lines[mid], &lines[lo], distances ) < 0 ) {
+            lev_swap ( &lines[mid], &lines[lo] );
+        }
+        if ( lev_sort ( &lines[hi], &lines[lo], distances ) < 0 ) {
+            lev_swap ( &lines[hi], &lines[lo] );
+        }
+        if ( lev_sort ( &lines[hi], &lines[mid], distances ) < 0 ) {
+            lev_swap ( &lines[hi], &lines[mid] );
+        }
+        unsigned int pivot = lines[mid];
+        long         i     = lo, j = hi;
+        while ( i <= j ) {
+            while ( lev_sort ( &lines[i], &pivot, distances ) < 0 ) {
+                i++;
+            }
+            while ( lev_sort ( &lines[j], &pivot, distances ) > 0 ) {
+                j--;
+            }
+            if ( i <= j ) {
+                lev_swap ( &lines[i], &lines[j] );
+                i++;
+                j--;
+            }
+        }
+        // [lo,j] is before the pivot, [i,hi] after it.
+        if ( (long) k <= j ) {
+            hi = j;
+        }
+        else if ( (long) k >= i ) {
+            lo = i;
+        }
+        else {
+            break;
+        }
+    }
+}
+
+/**
+ * @param lines The rows
+ * @param length The number of rows
+ * @param sorted The number of rows already sorted, these are better than the rest.
+ * @param needed The number of rows that should be sorted.
+ * @param distances The distance of each entry
+ *
+ * Sort the best rows after the already sorted rows, the rest stays unsorted.
+ *
+ * @returns the number of sorted rows.
+ */
+static unsigned int lev_sort_best ( unsigned int *lines, unsigned int length, unsigned int sorted, unsigned int needed, int *distances )
+{
+    needed = MIN ( needed, length );
+    if ( needed <= sorted ) {
+        return sorted;
+    }
+    unsigned int count = needed - sorted;
+    if ( needed < length ) {
+        lev_select ( &lines[sorted], length - sorted, count, distances );
+    }
+    g_qsort_with_data ( &lines[sorted], count, sizeof ( int ), lev_sort, distances );
+    return needed;
 }
 
 /**
@@ -598,6 +690,11 @@ void rofi_view_set_selected_line ( RofiViewState *state, unsigned int selected_l
 
 void rofi_view_free ( RofiViewState *state )
 {
+    rofi_view_filter_cancel ( state );
+    if ( state->rows_added_source > 0 ) {
+        g_source_remove ( state->rows_added_source );
+        state->rows_added_source = 0;
+    }
     if ( state->tokens ) {
         helper_tokenize_free ( state->tokens );
         state->tokens = NULL;
@@ -608,6 +705,12 @@ void rofi_view_free ( RofiViewState *state )
 
     g_free ( state->line_map );
     g_free ( state->distance );
+    g_free ( state->last_filter.text );
+    g_free ( state->last_filter.pattern );
+    rofi_view_filter_cache_clear ( state );
+    if ( state->highlight_cache != NULL ) {
+        g_hash_table_destroy ( state->highlight_cache );
+    }
     // Free the switcher boxes.
     // When state is free'ed we should no longer need these.
     g_free ( state->modi );
@@ -658,34 +761,137 @@ static RofiViewState * __rofi_view_state_create ( void )
     return g_malloc0 ( sizeof ( RofiViewState ) );
 }
 
+/** Number of rows a worker claims at once. */
+#define FILTER_BLOCK_SIZE             256
+/** Minimum number of rows for each worker before a filter run is spread over multiple threads. */
+#define FILTER_MIN_ROWS_PER_THREAD    1000
+/** Target duration of one filter step in microseconds, the main loop is blocked for this long. */
+#define FILTER_STEP_USEC              8000
+/** Minimum number of rows filtered in one step. */
+#define FILTER_STEP_MIN_ROWS          4096
+/** Time in microseconds after which the matches found so far are shown. */
+#define FILTER_PARTIAL_USEC           100000
+/** Maximum number of matches shown while the filter run continues. */
+#define FILTER_PARTIAL_ROWS           100
+/** Number of best rows sorted when a filter run completes, the rest is sorted when scrolled to. */
+#define FILTER_SORT_ROWS              100
+/** Number of filter results kept per view. */
+#define FILTER_CACHE_ENTRIES          8
+/** Maximum number of rows in all cached filter results together. */
+#define FILTER_CACHE_ROWS             ( 1 << 22 )
+/** Maximum number of rows the highlighted ranges are kept for. */
+#define HIGHLIGHT_CACHE_ROWS          1024
+
 /**
- * Thread state for workers started for the view.
+ * Highlighted ranges of a displayed row.
  */
-typedef struct _thread_state_view
+typedef struct
 {
-    /** Generic thread state. */
-    thread_state  st;
+    /** The displayed text the ranges were found in. */
+    char   *text;
+    /** The ranges (#rofi_range_pair), NULL when highlighting is not supported. */
+    GArray *ranges;
+} highlight_cache_entry;
 
-    /** Condition. */
-    GCond         *cond;
-    /** Lock for condition. */
-    GMutex        *mutex;
-    /** Count that is protected by lock. */
-    unsigned int  *acount;
+/**
+ * Cached result of a filter run, so typing the same input again does not match the rows again.
+ */
+typedef struct
+{
+    /** The user input. */
+    char         *text;
+    /** The preprocessed user input. */
+    char         *pattern;
+    /** Matching method used. */
+    unsigned int matching_method;
+    /** Case sensitivity used. */
+    unsigned int case_sensitive;
+    /** Tokenize setting used. */
+    unsigned int tokenize;
+    /** Normalize setting used. */
+    unsigned int normalize_match;
+    /** Sort setting used. */
+    unsigned int sort;
+    /** Sorting method used. */
+    unsigned int sorting_method;
+    /** Number of entries when filtered. */
+    unsigned int num_lines;
+    /** The matching rows. */
+    unsigned int *line_map;
+    /** The distance of each matching row, NULL when not sorted. */
+    int          *distance;
+    /** Number of matching rows. */
+    unsigned int length;
+    /** Number of rows at the start of line_map that are sorted. */
+    unsigned int sorted_lines;
+} filter_cache_entry;
 
+/**
+ * State of one filter run.
+ * The rows are filtered in steps from the main loop, so a new keystroke can
+ * cancel the run. Within a step workers claim blocks of FILTER_BLOCK_SIZE
+ * rows by advancing the cursor, so a worker that hits cheap rows simply claims
+ * more blocks.
+ */
+typedef struct _filter_job
+{
     /** Current state. */
     RofiViewState *state;
-    /** Start row for this worker. */
-    unsigned int  start;
-    /** Stop row for this worker. */
-    unsigned int  stop;
-    /** Rows processed. */
-    unsigned int  count;
-
+    /** Generation of the run, increases with every started run. */
+    guint         generation;
+    /** Time the run started. */
+    gint64        start_time;
+    /** Number of rows to filter. */
+    unsigned int  rows;
+    /** The next row to filter. */
+    unsigned int  position;
+    /** Number of matches, these are stored at the start of line_map. */
+    unsigned int  matched;
+    /** The rows to filter, compacted to the matches while filtering. */
+    unsigned int  *line_map;
+    /** The distance of each entry, kept apart from the shown result until the run completes. (NULL when not sorting) */
+    int           *distance;
+    /** When set, the rows index the previous line_map instead of the entries. */
+    gboolean      refine;
+    /** Strings of the mode to match on directly, NULL to match through the mode. */
+    const RofiStringTable *table;
+    /** Time part of the result was last shown. (0 when not shown) */
+    gint64        partial_time;
+
+    /** First row of the current step. */
+    unsigned int  step_start;
+    /** Row after the last row of the current step. */
+    unsigned int  step_stop;
+    /** Number of blocks the step is split in. */
+    unsigned int  num_blocks;
+    /** Next block to claim. (atomic) */
+    gint          cursor;
+    /** Number of matches found in each block. */
+    unsigned int  *block_count;
+
+    /** User input to filter. */
+    char          *text;
     /** Pattern input to filter. */
-    const char    *pattern;
+    char          *pattern;
     /** Length of pattern. */
     glong         plen;
+} filter_job;
+
+/**
+ * Thread state for workers started for the view.
+ */
+typedef struct _thread_state_view
+{
+    /** Generic thread state. */
+    thread_state st;
+    /** Signalled when a worker is done. */
+    GCond        *cond;
+    /** Protects acount. */
+    GMutex       *mutex;
+    /** Number of workers still running. */
+    unsigned int *acount;
+    /** The filter run this worker helps with. */
+    filter_job   *job;
 } thread_state_view;
 /**
  * @param data A thread_state object.
@@ -699,38 +905,195 @@ static void rofi_view_call_thread ( gpointer data, gpointer user_data )
     t->callback ( t, user_data );
 }
 
-static void filter_elements ( thread_state *ts, G_GNUC_UNUSED gpointer user_data )
-{
-    thread_state_view *t = (thread_state_view *) ts;
-    for ( unsigned int i = t->start; i < t->stop; i++ ) {
-        int match = mode_token_match ( t->state->sw, t->state->tokens, i );
-        // If each token was matched, add it to list.
-        if ( match ) {
-            t->state->line_map[t->start + t->count] = i;
-            if ( config.sort ) {
-                // This is inefficient, need to fix it.
-                char  * str = mode_get_completion ( t->state->sw, i );
-                glong slen  = g_utf8_strlen ( str, -1 );
-                switch ( config.sorting_method_enum )
-                {
-                case SORT_FZF:
-                    t->state->distance[i] = rofi_scorer_fuzzy_evaluate ( t->pattern, t->plen, str, slen );
-                    break;
-                case SORT_NORMAL:
-                default:
-                    t->state->distance[i] = levenshtein ( t->pattern, t->plen, str, slen );
-                    break;
-                }
-                g_free ( str );
+/**
+ * @param job The filter run.
+ * @param start The first row.
+ * @param stop The row after the last row.
+ *
+ * Match the rows and compact the matches to the start of the range.
+ *
+ * @returns the number of matched rows.
+ */
+static unsigned int filter_rows ( filter_job *job, unsigned int start, unsigned int stop )
+{
+    RofiViewState         *state = job->state;
+    const RofiStringTable *table = job->table;
+    unsigned int          count  = 0;
+    if ( job->refine ) {
+        for ( unsigned int i = start; i < stop; i++ ) {
+            // The result is compacted in place, the write position never passes the read position.
+            unsigned int index = job->line_map[i];
+            int          match = ( table != NULL && index < table->length ) ?
+                                 helper_string_table_token_match ( table, state->tokens, index ) :
+                                 mode_token_match ( state->sw, state->tokens, index );
+            // If each token was matched, add it to list.
+            if ( match ) {
+                job->line_map[start + count] = index;
+                count++;
             }
-            t->count++;
         }
     }
-    if ( t->acount != NULL  ) {
-        g_mutex_lock ( t->mutex );
-        ( *( t->acount ) )--;
-        g_cond_signal ( t->cond );
-        g_mutex_unlock ( t->mutex );
+    else if ( table != NULL && stop <= table->length ) {
+        for ( unsigned int i = start; i < stop; i++ ) {
+            if ( helper_string_table_token_match ( table, state->tokens, i ) ) {
+                job->line_map[start + count] = i;
+                count++;
+            }
+        }
+    }
+    else {
+        mode_token_match_batch ( state->sw, state->tokens, start, stop, &( job->line_map[start] ), &count );
+    }
+    if ( config.sort ) {
+        for ( unsigned int i = start; i < start + count; i++ ) {
+            unsigned int index = job->line_map[i];
+            glong        slen  = 0;
+            char         *tmp  = NULL;
+            const char   *str  = mode_peek_completion ( state->sw, index, &slen );
+            if ( str == NULL ) {
+                // The mode cannot lend its string, score a copy.
+                str  = tmp = mode_get_completion ( state->sw, index );
+                slen = g_utf8_strlen ( str, -1 );
+            }
+            switch ( config.sorting_method_enum )
+            {
+            case SORT_FZF:
+                job->distance[index] = rofi_scorer_fuzzy_evaluate ( job->pattern, job->plen, str, slen );
+                break;
+            case SORT_NORMAL:
+            default:
+                job->distance[index] = levenshtein ( job->pattern, job->plen, str, slen );
+                break;
+            }
+            g_free ( tmp );
+        }
+    }
+    return count;
+}
+
+static void filter_elements ( thread_state *ts, G_GNUC_UNUSED gpointer user_data )
+{
+    thread_state_view *t   = (thread_state_view *) ts;
+    filter_job        *job = t->job;
+    unsigned int      block;
+    while ( ( block = (unsigned int) g_atomic_int_add ( &( job->cursor ), 1 ) ) < job->num_blocks ) {
+        unsigned int start = job->step_start + block * FILTER_BLOCK_SIZE;
+        unsigned int stop  = MIN ( job->step_stop, start + FILTER_BLOCK_SIZE );
+        job->block_count[block] = filter_rows ( job, start, stop );
+    }
+    // Signal completion to the thread waiting in filter_job_run.
+    g_mutex_lock ( t->mutex );
+    ( *( t->acount ) )--;
+    g_cond_signal ( t->cond );
+    g_mutex_unlock ( t->mutex );
+}
+
+/**
+ * @param job The filter run to execute.
+ * @param stop The row after the last row to filter in this step.
+ *
+ * Filters the rows from the current position up to stop. When there are
+ * enough rows, one worker per thread is pushed on the pool and the calling
+ * thread joins in. Small steps are filtered directly without going through the
+ * pool. The matches are appended to the matches of the previous steps.
+ */
+static void filter_job_run ( filter_job *job, unsigned int stop )
+{
+    job->step_start = job->position;
+    job->step_stop  = stop;
+    // Looked up every step, the mode can add or replace its strings in between.
+    job->table = mode_get_string_table ( job->state->sw );
+    if ( !helper_string_table_usable ( job->table, job->state->tokens ) ) {
+        job->table = NULL;
+    }
+    unsigned int rows = stop - job->position;
+    unsigned int nt   = MIN ( config.threads, rows / FILTER_MIN_ROWS_PER_THREAD );
+    if ( nt <= 1 || tpool == NULL ) {
+        unsigned int count = filter_rows ( job, job->step_start, stop );
+        if ( job->matched != job->step_start ) {
+            memmove ( &( job->line_map[job->matched] ), &( job->line_map[job->step_start] ), sizeof ( unsigned int ) * count );
+        }
+        job->matched += count;
+        job->position = stop;
+        return;
+    }
+    job->num_blocks  = ( rows + FILTER_BLOCK_SIZE - 1 ) / FILTER_BLOCK_SIZE;
+    job->block_count = g_malloc0_n ( job->num_blocks, sizeof ( unsigned int ) );
+    job->cursor      = 0;
+
+    GCond        cond;
+    GMutex       mutex;
+    unsigned int count = nt;
+    g_cond_init ( &cond );
+    g_mutex_init ( &mutex );
+    thread_state_view *states = g_malloc0_n ( nt, sizeof ( thread_state_view ) );
+    for ( unsigned int i = 0; i < nt; i++ ) {
+        states[i].st.callback = filter_elements;
+        states[i].cond        = &cond;
+        states[i].mutex       = &mutex;
+        states[i].acount      = &count;
+        states[i].job         = job;
+        if ( i > 0 ) {
+            g_thread_pool_push ( tpool, &states[i], NULL );
+        }
+    }
+    // Run one in this thread.
+    rofi_view_call_thread ( &states[0], NULL );
+    // All blocks are claimed, wait for the workers to finish theirs.
+    g_mutex_lock ( &mutex );
+    while ( count > 0 ) {
+        g_cond_wait ( &cond, &mutex );
+    }
+    g_mutex_unlock ( &mutex );
+    g_mutex_clear ( &mutex );
+    g_cond_clear ( &cond );
+    g_free ( states );
+
+    for ( unsigned int b = 0; b < job->num_blocks; b++ ) {
+        unsigned int start = job->step_start + b * FILTER_BLOCK_SIZE;
+        if ( job->matched != start ) {
+            memmove ( &( job->line_map[job->matched] ), &( job->line_map[start] ), sizeof ( unsigned int ) * ( job->block_count[b] ) );
+        }
+        job->matched += job->block_count[b];
+    }
+    g_free ( job->block_count );
+    job->block_count = NULL;
+    job->position    = stop;
+}
+
+/**
+ * @param job The filter run to free.
+ *
+ * Free the filter run and its buffers.
+ */
+static void filter_job_free ( filter_job *job )
+{
+    if ( job == NULL ) {
+        return;
+    }
+    g_free ( job->line_map );
+    g_free ( job->distance );
+    g_free ( job->text );
+    g_free ( job->pattern );
+    g_free ( job );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Cancel the filter run in progress, the view keeps showing the previous result.
+ */
+static void rofi_view_filter_cancel ( RofiViewState *state )
+{
+    if ( state->filter_source > 0 ) {
+        g_source_remove ( state->filter_source );
+        state->filter_source = 0;
+    }
+    if ( state->filter_job != NULL ) {
+        g_debug ( "Filter run %u cancelled at row %u/%u", state->filter_job->generation,
+                  state->filter_job->position, state->filter_job->rows );
+        filter_job_free ( state->filter_job );
+        state->filter_job = NULL;
     }
 }
 
@@ -1043,9 +1406,95 @@ inline static void rofi_view_nav_last ( RofiViewState * state )
     listview_set_selected ( state->list_view, -1 );
 }
 
+/**
+ * @param state The handle to the view
+ * @param index The row that is needed
+ *
+ * Make sure the rows up to index are sorted, the rows are sorted in growing
+ * chunks when scrolling down.
+ */
+static void rofi_view_sort_lines ( RofiViewState *state, unsigned int index )
+{
+    if ( index < state->sorted_lines || state->sorted_lines >= state->filtered_lines ) {
+        return;
+    }
+    unsigned int needed = MAX ( index + 1, state->sorted_lines * 2 );
+    state->sorted_lines = lev_sort_best ( state->line_map, state->filtered_lines, state->sorted_lines, needed, state->distance );
+}
+
+static void highlight_cache_entry_free ( gpointer data )
+{
+    highlight_cache_entry *entry = (highlight_cache_entry *) data;
+    g_free ( entry->text );
+    if ( entry->ranges != NULL ) {
+        g_array_free ( entry->ranges, TRUE );
+    }
+    g_free ( entry );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Forget the highlighted ranges, called when the tokens change.
+ */
+static void rofi_view_highlight_cache_clear ( RofiViewState *state )
+{
+    if ( state->highlight_cache != NULL ) {
+        g_hash_table_remove_all ( state->highlight_cache );
+    }
+}
+
+/**
+ * @param state The handle to the view
+ * @param tokens The tokens of the shown result
+ * @param row The entry displayed
+ * @param text The text displayed for the entry
+ *
+ * Get the ranges to highlight, the rows are only matched again when drawn for the
+ * first time with the current tokens (or when their text changed).
+ *
+ * @returns the ranges, or NULL if highlighting is not supported.
+ */
+static const GArray *rofi_view_get_highlight_ranges ( RofiViewState *state, rofi_int_matcher **tokens, unsigned int row, const char *text )
+{
+    if ( state->highlight_cache == NULL ) {
+        state->highlight_cache = g_hash_table_new_full ( g_direct_hash, g_direct_equal, NULL, highlight_cache_entry_free );
+    }
+    highlight_cache_entry *entry = g_hash_table_lookup ( state->highlight_cache, GUINT_TO_POINTER ( row ) );
+    if ( entry != NULL && g_strcmp0 ( entry->text, text ) == 0 ) {
+        return entry->ranges;
+    }
+    if ( entry == NULL && g_hash_table_size ( state->highlight_cache ) >= HIGHLIGHT_CACHE_ROWS ) {
+        // Scrolled through a lot of rows, start over.
+        g_hash_table_remove_all ( state->highlight_cache );
+    }
+    entry         = g_malloc0 ( sizeof ( highlight_cache_entry ) );
+    entry->text   = g_strdup ( text );
+    entry->ranges = helper_token_match_get_ranges ( tokens, text );
+    g_hash_table_replace ( state->highlight_cache, GUINT_TO_POINTER ( row ), entry );
+    return entry->ranges;
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Get the tokens of the shown result, these are created on first use after the
+ * result was taken from the cache.
+ *
+ * @returns the tokens, or NULL when not filtering.
+ */
+static rofi_int_matcher **rofi_view_get_tokens ( RofiViewState *state )
+{
+    if ( state->tokens == NULL && state->last_filter.pattern != NULL ) {
+        state->tokens = helper_tokenize ( state->last_filter.pattern, config.case_sensitive );
+    }
+    return state->tokens;
+}
+
 static void update_callback ( textbox *t, icon *ico, unsigned int index, void *udata, TextBoxFontType *type, gboolean full )
 {
     RofiViewState *state = (RofiViewState *) udata;
+    rofi_view_sort_lines ( state, index );
     if ( full ) {
         GList *add_list = NULL;
         int   fstate    = 0;
@@ -1068,10 +1517,12 @@ static void update_callback ( textbox *t, icon *ico, unsigned int index, void *u
             icon_set_surface ( ico, icon );
         }
 
-        if ( state->tokens ) {
+        rofi_int_matcher **tokens = rofi_view_get_tokens ( state );
+        if ( tokens ) {
             RofiHighlightColorStyle th = { ROFI_HL_BOLD | ROFI_HL_UNDERLINE, { 0.0, 0.0, 0.0, 0.0 } };
             th = rofi_theme_get_highlight ( WIDGET ( t ), "highlight", th );
-            helper_token_match_get_pango_attr ( th, state->tokens, textbox_get_visible_text ( t ), list );
+            const GArray *ranges = rofi_view_get_highlight_ranges ( state, tokens, state->line_map[index], textbox_get_visible_text ( t ) );
+            helper_token_match_set_pango_attr_ranges ( th, ranges, list );
         }
         for ( GList *iter = g_list_first ( add_list ); iter != NULL; iter = g_list_next ( iter ) ) {
             pango_attr_list_insert ( list, (PangoAttribute *) ( iter->data ) );
@@ -1131,23 +1582,295 @@ void rofi_view_update ( RofiViewState *state, gboolean qr )
 
 static void _rofi_view_reload_row ( RofiViewState *state )
 {
+    unsigned int num_lines = mode_get_num_entries ( state->sw );
+    unsigned int *line_map = g_malloc0_n ( num_lines, sizeof ( unsigned int ) );
+    int          *distance = g_malloc0_n ( num_lines, sizeof ( int ) );
+    // Keep showing the rows of the previous result that still exist until the new result is complete.
+    unsigned int j = 0, sorted = 0;
+    for ( unsigned int i = 0; i < state->filtered_lines; i++ ) {
+        unsigned int index = state->line_map[i];
+        if ( index < num_lines ) {
+            line_map[j]     = index;
+            distance[index] = state->distance[index];
+            j++;
+            if ( i < state->sorted_lines ) {
+                sorted++;
+            }
+        }
+    }
     g_free ( state->line_map );
     g_free ( state->distance );
-    state->num_lines = mode_get_num_entries ( state->sw );
-    state->line_map  = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
-    state->distance  = g_malloc0_n ( state->num_lines, sizeof ( int ) );
+    state->num_lines      = num_lines;
+    state->line_map       = line_map;
+    state->distance       = distance;
+    state->filtered_lines = j;
+    state->sorted_lines   = sorted;
+    listview_set_num_elements ( state->list_view, state->filtered_lines );
     listview_set_max_lines ( state->list_view, state->num_lines );
     rofi_view_reload_message_bar ( state );
 }
 
-static void rofi_view_refilter ( RofiViewState *state )
+/**
+ * @param state The handle to the view
+ *
+ * Forget the previous filter run, the next run will match all rows.
+ */
+static void rofi_view_last_filter_clear ( RofiViewState *state )
 {
-    if ( state->sw == NULL ) {
+    g_free ( state->last_filter.text );
+    g_free ( state->last_filter.pattern );
+    state->last_filter.text    = NULL;
+    state->last_filter.pattern = NULL;
+}
+
+/**
+ * @param state The handle to the view
+ * @param text The user input
+ * @param pattern The preprocessed user input
+ *
+ * Remember the filter run, so the next run can narrow down its result.
+ */
+static void rofi_view_last_filter_store ( RofiViewState *state, const char *text, const char *pattern )
+{
+    rofi_view_last_filter_clear ( state );
+    state->last_filter.text            = g_strdup ( text );
+    state->last_filter.pattern         = g_strdup ( pattern );
+    state->last_filter.matching_method = config.matching_method;
+    state->last_filter.case_sensitive  = config.case_sensitive;
+    state->last_filter.tokenize        = config.tokenize;
+    state->last_filter.normalize_match = config.normalize_match;
+    state->last_filter.sort            = config.sort;
+}
+
+/**
+ * @param pattern The preprocessed user input
+ *
+ * @returns TRUE if one of the tokens in pattern is negated.
+ */
+static gboolean rofi_view_pattern_has_negation ( const char *pattern )
+{
+    if ( config.matching_negate_char == '\0' ) {
+        return FALSE;
+    }
+    if ( pattern[0] == config.matching_negate_char ) {
+        return TRUE;
+    }
+    if ( config.tokenize ) {
+        for ( const char *iter = pattern; iter[0] != '\0' && iter[1] != '\0'; iter++ ) {
+            if ( iter[0] == ' ' && iter[1] == config.matching_negate_char ) {
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @param state The handle to the view
+ * @param text The user input
+ * @param pattern The preprocessed user input
+ *
+ * When the input only got extended, every token matches a subset of what its
+ * previous version matched. In that case only the rows in the current result
+ * have to be matched again. Regex (alternation, optional parts) and negated
+ * tokens can match more rows when they grow, so these always do a full scan.
+ *
+ * @returns TRUE if the previous result can be narrowed down.
+ */
+static gboolean rofi_view_filter_can_refine ( const RofiViewState *state, const char *text, const char *pattern )
+{
+    if ( state->last_filter.text == NULL || state->last_filter.pattern == NULL || pattern == NULL ) {
+        return FALSE;
+    }
+    if ( config.matching_method == MM_REGEX ) {
+        return FALSE;
+    }
+    if ( state->last_filter.matching_method != config.matching_method ||
+         state->last_filter.case_sensitive != config.case_sensitive ||
+         state->last_filter.tokenize != config.tokenize ||
+         state->last_filter.normalize_match != (unsigned int) config.normalize_match ||
+         state->last_filter.sort != config.sort ) {
+        return FALSE;
+    }
+    // Both the raw and preprocessed input should be extended, combi changes the enabled modi based on the raw input.
+    if ( !g_str_has_prefix ( text, state->last_filter.text ) || !g_str_has_prefix ( pattern, state->last_filter.pattern ) ) {
+        return FALSE;
+    }
+    return !rofi_view_pattern_has_negation ( pattern );
+}
+
+static void filter_cache_entry_free ( filter_cache_entry *entry )
+{
+    g_free ( entry->text );
+    g_free ( entry->pattern );
+    g_free ( entry->line_map );
+    g_free ( entry->distance );
+    g_free ( entry );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Drop all cached filter results, for example when the entries changed.
+ */
+static void rofi_view_filter_cache_clear ( RofiViewState *state )
+{
+    filter_cache_entry *entry;
+    while ( ( entry = g_queue_pop_head ( &( state->filter_cache ) ) ) != NULL ) {
+        filter_cache_entry_free ( entry );
+    }
+    state->filter_cache_rows = 0;
+}
+
+/**
+ * @param state The handle to the view
+ * @param text The user input
+ * @param pattern The preprocessed user input
+ *
+ * Remember the result of the completed filter run in the view. The least recently
+ * used results are dropped to stay within FILTER_CACHE_ENTRIES and FILTER_CACHE_ROWS.
+ */
+static void rofi_view_filter_cache_store ( RofiViewState *state, const char *text, const char *pattern )
+{
+    if ( state->filtered_lines > FILTER_CACHE_ROWS ) {
         return;
     }
+    filter_cache_entry *entry = g_malloc0 ( sizeof ( filter_cache_entry ) );
+    entry->text            = g_strdup ( text );
+    entry->pattern         = g_strdup ( pattern );
+    entry->matching_method = config.matching_method;
+    entry->case_sensitive  = config.case_sensitive;
+    entry->tokenize        = config.tokenize;
+    entry->normalize_match = config.normalize_match;
+    entry->sort            = config.sort;
+    entry->sorting_method  = config.sorting_method_enum;
+    entry->num_lines       = state->num_lines;
+    entry->length          = state->filtered_lines;
+    entry->sorted_lines    = state->sorted_lines;
+    entry->line_map        = g_memdup ( state->line_map, entry->length * sizeof ( unsigned int ) );
+    if ( config.sort ) {
+        entry->distance = g_malloc_n ( MAX ( entry->length, 1 ), sizeof ( int ) );
+        for ( unsigned int i = 0; i < entry->length; i++ ) {
+            entry->distance[i] = state->distance[entry->line_map[i]];
+        }
+    }
+    g_queue_push_head ( &( state->filter_cache ), entry );
+    state->filter_cache_rows += entry->length;
+    while ( g_queue_get_length ( &( state->filter_cache ) ) > FILTER_CACHE_ENTRIES ||
+            state->filter_cache_rows > FILTER_CACHE_ROWS ) {
+        filter_cache_entry *last = g_queue_pop_tail ( &( state->filter_cache ) );
+        state->filter_cache_rows -= last->length;
+        filter_cache_entry_free ( last );
+    }
+}
+
+/**
+ * @param state The handle to the view
+ * @param text The user input
+ * @param pattern The preprocessed user input
+ *
+ * Look up the result for the input, and when found make it the result of the view.
+ *
+ * @returns TRUE if the result was cached.
+ */
+static gboolean rofi_view_filter_cache_lookup ( RofiViewState *state, const char *text, const char *pattern )
+{
+    for ( GList *iter = state->filter_cache.head; iter != NULL; iter = g_list_next ( iter ) ) {
+        filter_cache_entry *entry = (filter_cache_entry *) iter->data;
+        // Combi enables modi based on the raw input, so both have to match.
+        if ( g_strcmp0 ( entry->text, text ) != 0 || g_strcmp0 ( entry->pattern, pattern ) != 0 ) {
+            continue;
+        }
+        if ( entry->matching_method != config.matching_method ||
+             entry->case_sensitive != config.case_sensitive ||
+             entry->tokenize != config.tokenize ||
+             entry->normalize_match != (unsigned int) config.normalize_match ||
+             entry->sort != config.sort ||
+             entry->sorting_method != config.sorting_method_enum ||
+             entry->num_lines != state->num_lines ) {
+            continue;
+        }
+        // Most recently used goes to the front.
+        g_queue_unlink ( &( state->filter_cache ), iter );
+        g_queue_push_head_link ( &( state->filter_cache ), iter );
+
+        memcpy ( state->line_map, entry->line_map, entry->length * sizeof ( unsigned int ) );
+        if ( entry->distance != NULL ) {
+            for ( unsigned int i = 0; i < entry->length; i++ ) {
+                state->distance[entry->line_map[i]] = entry->distance[i];
+            }
+        }
+        state->filtered_lines = entry->length;
+        state->sorted_lines   = entry->sorted_lines;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Update the widgets that show the filter result.
+ */
+static void rofi_view_refilter_update ( RofiViewState *state )
+{
+    listview_set_num_elements ( state->list_view, state->filtered_lines );
+
+    if ( state->tb_filtered_rows ) {
+        char *r = g_strdup_printf ( "%u", state->filtered_lines );
+        textbox_text ( state->tb_filtered_rows, r );
+        g_free ( r );
+    }
+    if ( state->tb_total_rows ) {
+        char *r = g_strdup_printf ( "%u", state->num_lines );
+        textbox_text ( state->tb_total_rows, r );
+        g_free ( r );
+    }
+    TICK_N ( "Update filter lines" );
+
+    // Size the window.
+    int height = rofi_view_calculate_height ( state );
+    if ( height != state->height ) {
+        state->height = height;
+        rofi_view_calculate_window_position ( state );
+        rofi_view_window_update_size ( state );
+        g_debug ( "Resize based on re-filter" );
+    }
+    TICK_N ( "Filter resize window based on window " );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Show the new (complete) result of the view.
+ */
+static void rofi_view_filter_done ( RofiViewState *state )
+{
+    rofi_view_refilter_update ( state );
+
+    if ( config.auto_select == TRUE && state->filtered_lines == 1 && state->num_lines > 1 ) {
+        ( state->selected_line ) = state->line_map[listview_get_selected ( state->list_view  )];
+        state->retv              = MENU_OK;
+        state->quit              = TRUE;
+    }
+    TICK_N ( "Filter done" );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Start a new filter run for the current input, a run in progress is cancelled.
+ * Without input the result is set directly and no run is started.
+ */
+static void rofi_view_filter_start ( RofiViewState *state )
+{
+    rofi_view_filter_cancel ( state );
+    state->refilter = FALSE;
     TICK_N ( "Filter start" );
     if ( state->reload ) {
         _rofi_view_reload_row ( state );
+        rofi_view_last_filter_clear ( state );
+        rofi_view_filter_cache_clear ( state );
         state->reload = FALSE;
     }
     TICK_N ( "Filter reload rows" );
@@ -1155,105 +1878,363 @@ static void rofi_view_refilter ( RofiViewState *state )
         helper_tokenize_free ( state->tokens );
         state->tokens = NULL;
     }
+    rofi_view_highlight_cache_clear ( state );
     TICK_N ( "Filter tokenize" );
     if ( state->text && strlen ( state->text->text ) > 0 ) {
-        unsigned int j        = 0;
-        gchar        *pattern = mode_preprocess_input ( state->sw, state->text->text );
-        glong        plen     = pattern ? g_utf8_strlen ( pattern, -1 ) : 0;
-        state->tokens = helper_tokenize ( pattern, config.case_sensitive );
-        /**
-         * On long lists it can be beneficial to parallelize.
-         * If number of threads is 1, no thread is spawn.
-         * If number of threads > 1 and there are enough (> 1000) items, spawn jobs for the thread pool.
-         * For large lists with 8 threads I see a factor three speedup of the whole function.
-         */
-        unsigned int      nt = MAX ( 1, state->num_lines / 500 );
-        thread_state_view states[nt];
-        GCond             cond;
-        GMutex            mutex;
-        g_mutex_init ( &mutex );
-        g_cond_init ( &cond );
-        unsigned int count = nt;
-        unsigned int steps = ( state->num_lines + nt ) / nt;
-        for ( unsigned int i = 0; i < nt; i++ ) {
-            states[i].state       = state;
-            states[i].start       = i * steps;
-            states[i].stop        = MIN ( state->num_lines, ( i + 1 ) * steps );
-            states[i].count       = 0;
-            states[i].cond        = &cond;
-            states[i].mutex       = &mutex;
-            states[i].acount      = &count;
-            states[i].plen        = plen;
-            states[i].pattern     = pattern;
-            states[i].st.callback = filter_elements;
-            if ( i > 0 ) {
-                g_thread_pool_push ( tpool, &states[i], NULL );
-            }
-        }
-        // Run one in this thread.
-        rofi_view_call_thread ( &states[0], NULL );
-        // No need to do this with only one thread.
-        if ( nt > 1 ) {
-            g_mutex_lock ( &mutex );
-            while ( count > 0 ) {
-                g_cond_wait ( &cond, &mutex );
-            }
-            g_mutex_unlock ( &mutex );
+        char *pattern = mode_preprocess_input ( state->sw, state->text->text );
+        if ( rofi_view_filter_cache_lookup ( state, state->text->text, pattern ) ) {
+            // Typed before, no need to tokenize or match.
+            rofi_view_last_filter_store ( state, state->text->text, pattern );
+            g_free ( pattern );
+            TICK_N ( "Filter cached result" );
+            rofi_view_filter_done ( state );
+            return;
         }
-        g_cond_clear ( &cond );
-        g_mutex_clear ( &mutex );
-        for ( unsigned int i = 0; i < nt; i++ ) {
-            if ( j != states[i].start ) {
-                memmove ( &( state->line_map[j] ), &( state->line_map[states[i].start] ), sizeof ( unsigned int ) * ( states[i].count ) );
+        filter_job *job = g_malloc0 ( sizeof ( filter_job ) );
+        job->state      = state;
+        job->generation = ++( state->filter_generation );
+        job->start_time = g_get_monotonic_time ();
+        job->text       = g_strdup ( state->text->text );
+        job->pattern    = pattern;
+        job->plen       = job->pattern ? g_utf8_strlen ( job->pattern, -1 ) : 0;
+        if ( config.sort ) {
+            // The shown result can still be sorted further while this run scores the rows.
+            job->distance = g_malloc0_n ( MAX ( state->num_lines, 1 ), sizeof ( int ) );
+        }
+        state->tokens = helper_tokenize ( job->pattern, config.case_sensitive );
+        // Only match the rows that survived the previous run when the input got extended.
+        job->refine = rofi_view_filter_can_refine ( state, job->text, job->pattern );
+        if ( job->refine ) {
+            job->rows     = state->filtered_lines;
+            job->line_map = g_malloc_n ( job->rows, sizeof ( unsigned int ) );
+            memcpy ( job->line_map, state->line_map, job->rows * sizeof ( unsigned int ) );
+            TICK_N ( "Filter refine previous result" );
+        }
+        else if ( ( job->line_map = mode_token_candidates ( state->sw, state->tokens, &( job->rows ) ) ) != NULL ) {
+            // Only match the rows the index of the mode could not rule out.
+            job->refine = TRUE;
+            while ( job->rows > 0 && job->line_map[job->rows - 1] >= state->num_lines ) {
+                job->rows--;
             }
-            j += states[i].count;
+            TICK_N ( "Filter index candidates" );
         }
-        if ( config.sort ) {
-            g_qsort_with_data ( state->line_map, j, sizeof ( int ), lev_sort, state->distance );
+        else {
+            job->rows     = state->num_lines;
+            job->line_map = g_malloc_n ( job->rows, sizeof ( unsigned int ) );
+            TICK_N ( "Filter all rows" );
         }
-
-        // Cleanup + bookkeeping.
-        state->filtered_lines = j;
-        g_free ( pattern );
+        state->filter_job = job;
     }
     else{
         for ( unsigned int i = 0; i < state->num_lines; i++ ) {
             state->line_map[i] = i;
         }
         state->filtered_lines = state->num_lines;
+        state->sorted_lines   = state->num_lines;
+        rofi_view_last_filter_clear ( state );
+        rofi_view_refilter_update ( state );
+    }
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Filter the next rows of the run in progress. The number of rows is tuned so
+ * one step takes about FILTER_STEP_USEC.
+ *
+ * @returns TRUE when all rows are filtered.
+ */
+static gboolean rofi_view_filter_step ( RofiViewState *state )
+{
+    filter_job   *job  = state->filter_job;
+    unsigned int first = job->position;
+    unsigned int rows  = MIN ( job->rows - first, MAX ( state->filter_step, FILTER_STEP_MIN_ROWS ) );
+    gint64       start = g_get_monotonic_time ();
+    filter_job_run ( job, first + rows );
+    gint64       elapsed = g_get_monotonic_time () - start;
+    // Short steps are too noisy to measure.
+    if ( rows >= FILTER_STEP_MIN_ROWS && elapsed > 0 ) {
+        guint64 step = ( (guint64) rows * FILTER_STEP_USEC ) / (guint64) elapsed;
+        // Do not grow too fast, a single fast step could be a fluke.
+        step               = MIN ( step, (guint64) rows * 4 );
+        state->filter_step = (unsigned int) MAX ( step, FILTER_STEP_MIN_ROWS );
+    }
+    return job->position == job->rows;
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Show the best matches found so far by the run in progress, so a slow run on a
+ * huge list does not leave the previous result on screen.
+ */
+static void rofi_view_filter_show_partial ( RofiViewState *state )
+{
+    filter_job   *job = state->filter_job;
+    unsigned int n    = MIN ( job->matched, FILTER_PARTIAL_ROWS );
+    if ( config.sort ) {
+        // The order of the matches does not matter until the final sort.
+        lev_sort_best ( job->line_map, job->matched, 0, n, job->distance );
+    }
+    memcpy ( state->line_map, job->line_map, n * sizeof ( unsigned int ) );
+    state->filtered_lines = n;
+    state->sorted_lines   = n;
+    // The shown result is incomplete, it cannot be narrowed down.
+    rofi_view_last_filter_clear ( state );
+    job->partial_time = g_get_monotonic_time ();
+    rofi_view_refilter_update ( state );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Complete the filter run, the matches become the result of the view.
+ */
+static void rofi_view_filter_finish ( RofiViewState *state )
+{
+    filter_job *job = state->filter_job;
+    state->filter_job = NULL;
+    memcpy ( state->line_map, job->line_map, job->matched * sizeof ( unsigned int ) );
+
+    // Cleanup + bookkeeping.
+    state->filtered_lines = job->matched;
+    state->sorted_lines   = job->matched;
+    if ( job->distance != NULL ) {
+        // The previous result is no longer shown, its distances can go.
+        int *distance = state->distance;
+        state->distance = job->distance;
+        job->distance   = distance;
     }
+    if ( config.sort ) {
+        // Only the first page(s) are looked at, sort the rest when scrolled to.
+        state->sorted_lines = lev_sort_best ( state->line_map, state->filtered_lines, 0, FILTER_SORT_ROWS, state->distance );
+    }
+    if ( job->pattern != NULL ) {
+        rofi_view_last_filter_store ( state, job->text, job->pattern );
+        rofi_view_filter_cache_store ( state, job->text, job->pattern );
+    }
+    else {
+        rofi_view_last_filter_clear ( state );
+    }
+    filter_job_free ( job );
     TICK_N ( "Filter matching done" );
-    listview_set_num_elements ( state->list_view, state->filtered_lines );
+    rofi_view_filter_done ( state );
+}
 
-    if ( state->tb_filtered_rows ) {
-        char *r = g_strdup_printf ( "%u", state->filtered_lines );
-        textbox_text ( state->tb_filtered_rows, r );
-        g_free ( r );
+/**
+ * @param state The handle to the view
+ *
+ * Complete the filter run in progress without returning to the main loop.
+ * Used before acting on the result.
+ */
+static void rofi_view_refilter_flush ( RofiViewState *state )
+{
+    if ( state->filter_job == NULL ) {
+        return;
     }
-    if ( state->tb_total_rows ) {
-        char *r = g_strdup_printf ( "%u", state->num_lines );
-        textbox_text ( state->tb_total_rows, r );
-        g_free ( r );
+    if ( state->filter_source > 0 ) {
+        g_source_remove ( state->filter_source );
+        state->filter_source = 0;
     }
-    TICK_N ( "Update filter lines" );
+    filter_job_run ( state->filter_job, state->filter_job->rows );
+    rofi_view_filter_finish ( state );
+}
 
-    if ( config.auto_select == TRUE && state->filtered_lines == 1 && state->num_lines > 1 ) {
-        ( state->selected_line ) = state->line_map[listview_get_selected ( state->list_view  )];
-        state->retv              = MENU_OK;
-        state->quit              = TRUE;
+static gboolean rofi_view_filter_idle ( gpointer data )
+{
+    RofiViewState *state = (RofiViewState *) data;
+    if ( rofi_view_filter_step ( state ) ) {
+        state->filter_source = 0;
+        rofi_view_filter_finish ( state );
+        // Handles auto-select and redraws, state can be freed after this.
+        rofi_view_maybe_update ( state );
+        return G_SOURCE_REMOVE;
     }
+    gint64 now = g_get_monotonic_time ();
+    if ( ( now - state->filter_job->start_time ) > FILTER_PARTIAL_USEC &&
+         ( now - state->filter_job->partial_time ) > FILTER_PARTIAL_USEC ) {
+        rofi_view_filter_show_partial ( state );
+        rofi_view_update ( state, TRUE );
+    }
+    return G_SOURCE_CONTINUE;
+}
 
-    // Size the window.
-    int height = rofi_view_calculate_height ( state );
-    if ( height != state->height ) {
-        state->height = height;
-        rofi_view_calculate_window_position ( state );
-        rofi_view_window_update_size ( state );
-        g_debug ( "Resize based on re-filter" );
+/**
+ * @param state The handle to the view
+ *
+ * Filter the view and wait for the result.
+ */
+static void rofi_view_refilter ( RofiViewState *state )
+{
+    if ( state->sw == NULL ) {
+        return;
+    }
+    rofi_view_filter_start ( state );
+    rofi_view_refilter_flush ( state );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Filter the view from the main loop. The first step is done directly, when
+ * rows are left these are filtered from an idle source so input keeps being
+ * handled. New input cancels the run and starts a new one.
+ */
+static void rofi_view_refilter_async ( RofiViewState *state )
+{
+    if ( state->sw == NULL ) {
+        return;
+    }
+    rofi_view_filter_start ( state );
+    if ( state->filter_job == NULL ) {
+        return;
+    }
+    if ( rofi_view_filter_step ( state ) ) {
+        rofi_view_filter_finish ( state );
+        return;
+    }
+    state->filter_source = g_idle_add ( rofi_view_filter_idle, state );
+}
+
+/**
+ * @param state The handle to the view
+ *
+ * Add the rows the mode appended to the result. Only the new rows are matched,
+ * with the tokens of the last completed run, and the matches are appended to the
+ * line map. When there is no completed result to add to, the view is reloaded.
+ */
+static void rofi_view_filter_append ( RofiViewState *state )
+{
+    unsigned int start = state->num_lines;
+    unsigned int stop  = MIN ( state->rows_added_stop, mode_get_num_entries ( state->sw ) );
+    state->rows_added_stop = 0;
+    if ( stop <= start || state->reload ) {
+        return;
+    }
+    gboolean filtered = state->text && strlen ( state->text->text ) > 0;
+    if ( state->filter_job != NULL || state->refilter || ( filtered && state->last_filter.text == NULL ) ) {
+        // The result is not complete, filter all rows again.
+        state->reload   = TRUE;
+        state->refilter = TRUE;
+        rofi_view_queue_redraw ();
+        return;
+    }
+    TICK_N ( "Filter append start" );
+    state->line_map = g_realloc_n ( state->line_map, stop, sizeof ( unsigned int ) );
+    state->distance = g_realloc_n ( state->distance, stop, sizeof ( int ) );
+    memset ( &( state->distance[start] ), 0, ( stop - start ) * sizeof ( int ) );
+    state->num_lines = stop;
+    // Cached results do not hold the new rows.
+    rofi_view_filter_cache_clear ( state );
+
+    if ( !filtered ) {
+        for ( unsigned int i = start; i < stop; i++ ) {
+            state->line_map[state->filtered_lines++] = i;
+        }
+        state->sorted_lines = state->filtered_lines;
+    }
+    else {
+        filter_job *job = g_malloc0 ( sizeof ( filter_job ) );
+        job->state    = state;
+        job->pattern  = g_strdup ( state->last_filter.pattern );
+        job->plen     = job->pattern ? g_utf8_strlen ( job->pattern, -1 ) : 0;
+        job->refine   = TRUE;
+        job->rows     = stop - start;
+        job->line_map = g_malloc_n ( job->rows, sizeof ( unsigned int ) );
+        // The new rows are added to the shown result, score them in place.
+        job->distance = state->distance;
+        for ( unsigned int i = 0; i < job->rows; i++ ) {
+            job->line_map[i] = start + i;
+        }
+        rofi_view_get_tokens ( state );
+        filter_job_run ( job, job->rows );
+        job->distance = NULL;
+        memcpy ( &( state->line_map[state->filtered_lines] ), job->line_map, job->matched * sizeof ( unsigned int ) );
+        state->filtered_lines += job->matched;
+        if ( !config.sort ) {
+            state->sorted_lines = state->filtered_lines;
+        }
+        else if ( job->matched > 0 ) {
+            // The new rows can rank above the sorted ones.
+            state->sorted_lines = lev_sort_best ( state->line_map, state->filtered_lines, 0, FILTER_SORT_ROWS, state->distance );
+        }
+        filter_job_free ( job );
+    }
+    listview_set_max_lines ( state->list_view, state->num_lines );
+    rofi_view_reload_message_bar ( state );
+    rofi_view_refilter_update ( state );
+    TICK_N ( "Filter append done" );
+}
+
+static gboolean rofi_view_rows_added_idle ( gpointer data )
+{
+    RofiViewState *state = (RofiViewState *) data;
+    state->rows_added_source = 0;
+    rofi_view_filter_append ( state );
+    rofi_view_queue_redraw ();
+    return G_SOURCE_REMOVE;
+}
+
+unsigned int *rofi_view_filter_rows ( Mode *sw, const char *input, unsigned int *length )
+{
+    // Only the fields used by the filter run are set, there are no widgets.
+    RofiViewState *state = g_malloc0 ( sizeof ( RofiViewState ) );
+    state->sw        = sw;
+    state->num_lines = mode_get_num_entries ( sw );
+
+    filter_job *job = g_malloc0 ( sizeof ( filter_job ) );
+    job->state    = state;
+    job->pattern  = mode_preprocess_input ( sw, input ? input : "" );
+    job->plen     = job->pattern ? g_utf8_strlen ( job->pattern, -1 ) : 0;
+    job->distance = g_malloc0_n ( MAX ( state->num_lines, 1 ), sizeof ( int ) );
+    state->tokens = helper_tokenize ( job->pattern, config.case_sensitive );
+    if ( ( job->line_map = mode_token_candidates ( sw, state->tokens, &( job->rows ) ) ) != NULL ) {
+        job->refine = TRUE;
+        while ( job->rows > 0 && job->line_map[job->rows - 1] >= state->num_lines ) {
+            job->rows--;
+        }
+    }
+    else {
+        job->rows     = state->num_lines;
+        job->line_map = g_malloc_n ( MAX ( job->rows, 1 ), sizeof ( unsigned int ) );
+    }
+    TICK_N ( "Filter rows start" );
+    filter_job_run ( job, job->rows );
+    TICK_N ( "Filter rows matched" );
+    if ( config.sort && job->plen > 0 ) {
+        g_qsort_with_data ( job->line_map, job->matched, sizeof ( int ), lev_sort, job->distance );
+        TICK_N ( "Filter rows sorted" );
+    }
+    unsigned int *retv = job->line_map;
+    *length       = job->matched;
+    job->line_map = NULL;
+    filter_job_free ( job );
+    helper_tokenize_free ( state->tokens );
+    g_free ( state );
+    return retv;
+}
+
+void rofi_view_rows_added ( unsigned int start, unsigned int stop )
+{
+    RofiViewState *state = current_active_menu;
+    if ( state == NULL || stop <= start ) {
+        return;
+    }
+    if ( start < state->num_lines ) {
+        // Rows the view already has changed.
+        rofi_view_reload ();
+        return;
+    }
+    state->rows_added_stop = MAX ( state->rows_added_stop, stop );
+    if ( state->rows_added_source == 0 ) {
+        // Show the first rows right away, after that add them in batches.
+        if ( state->num_lines == 0 ) {
+            state->rows_added_source = g_idle_add ( rofi_view_rows_added_idle, state );
+        }
+        else {
+            state->rows_added_source = g_timeout_add ( 1000 / 10, rofi_view_rows_added_idle, state );
+        }
     }
-    TICK_N ( "Filter resize window based on window " );
-    state->refilter = FALSE;
-    TICK_N ( "Filter done" );
 }
 /**
  * @param state The Menu Handle
@@ -1268,9 +2249,45 @@ void rofi_view_finalize ( RofiViewState *state )
     }
 }
 
+/**
+ * @param action The action
+ *
+ * @returns TRUE if the action edits the user input or moves the cursor in it.
+ */
+static gboolean rofi_view_action_is_edit ( KeyBindingAction action )
+{
+    switch ( action )
+    {
+    case CLEAR_LINE:
+    case MOVE_FRONT:
+    case MOVE_END:
+    case REMOVE_TO_EOL:
+    case REMOVE_TO_SOL:
+    case REMOVE_WORD_BACK:
+    case REMOVE_WORD_FORWARD:
+    case REMOVE_CHAR_FORWARD:
+    case MOVE_WORD_BACK:
+    case MOVE_WORD_FORWARD:
+    case REMOVE_CHAR_BACK:
+    case MOVE_CHAR_BACK:
+    case MOVE_CHAR_FORWARD:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
 static void rofi_view_trigger_global_action ( KeyBindingAction action )
 {
     RofiViewState *state = rofi_view_get_active ();
+    // Acting on the rows needs the complete filter result, editing the input starts a new run anyway.
+    if ( state != NULL && !rofi_view_action_is_edit ( action ) ) {
+        rofi_view_refilter_flush ( state );
+        if ( state->list_view != NULL ) {
+            // The row after the selected one is used by rofi_view_get_next_position.
+            rofi_view_sort_lines ( state, listview_get_selected ( state->list_view ) + 1 );
+        }
+    }
     switch ( action )
     {
     // Handling of paste
@@ -1525,6 +2542,9 @@ gboolean rofi_view_trigger_action ( RofiViewState *state, BindingsScope scope, g
     case SCOPE_MOUSE_SCROLLBAR:
     case SCOPE_MOUSE_MODE_SWITCHER:
     {
+        if ( scope != SCOPE_MOUSE_EDITBOX ) {
+            rofi_view_refilter_flush ( state );
+        }
         gint   x = state->mouse.x, y = state->mouse.y;
         widget *target = widget_find_mouse_target ( WIDGET ( state->main_window ), (WidgetType) scope, x, y );
         if ( target == NULL ) {
@@ -1641,7 +2661,7 @@ void rofi_view_maybe_update ( RofiViewState *state )
 
     // Update if requested.
     if ( state->refilter ) {
-        rofi_view_refilter ( state );
+        rofi_view_refilter_async ( state );
     }
     rofi_view_update ( state, TRUE );
 }
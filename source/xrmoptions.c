@@ -141,6 +141,8 @@ static XrmOption xrmOptions[] = {
       "Use sorting", CONFIG_DEFAULT },
     { xrm_String,  "sorting-method",            { .str   = &config.sorting_method                       }, NULL,
       "Choose the strategy used for sorting: normal (levenshtein) or fzf.", CONFIG_DEFAULT },
+    { xrm_Number,  "sorting-max-length",        { .num   = &config.sorting_max_length                   }, NULL,
+      "Maximum number of characters of an entry scored by the fzf sorting method (0 for no limit).", CONFIG_DEFAULT },
     { xrm_Boolean, "case-sensitive",            { .num   = &config.case_sensitive                       }, NULL,
       "Set case-sensitivity", CONFIG_DEFAULT },
     { xrm_Boolean, "cycle",                     { .num   = &config.cycle                                }, NULL,
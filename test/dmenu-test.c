@@ -0,0 +1,524 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2017 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <assert.h>
+#include <locale.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <xcb/xcb_ewmh.h>
+#include "display.h"
+#include "theme.h"
+#include "xcb.h"
+#include "xcb-internal.h"
+#include "rofi.h"
+#include "settings.h"
+#include "rofi-types.h"
+#include "helper.h"
+#include "mode.h"
+#include "view.h"
+#include "dialogs/dmenu.h"
+#include "widgets/textbox.h"
+#include "rofi-icon-fetcher.h"
+
+#include <check.h>
+
+ThemeWidget *rofi_theme = NULL;
+GThreadPool *tpool      = NULL;
+
+/** The rows as the view sees them, captured by rofi_view_filter_rows(). */
+static GPtrArray *rows_text    = NULL;
+static GPtrArray *rows_display = NULL;
+static GPtrArray *rows_icon    = NULL;
+/** The last icon name queried. */
+static char      *icon_query   = NULL;
+
+uint32_t rofi_icon_fetcher_query ( const char *name, G_GNUC_UNUSED const int size )
+{
+    g_free ( icon_query );
+    icon_query = g_strdup ( name );
+    return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced ( G_GNUC_UNUSED const char *name, G_GNUC_UNUSED const int wsize, G_GNUC_UNUSED const int hsize )
+{
+    return 0;
+}
+cairo_surface_t * rofi_icon_fetcher_get ( G_GNUC_UNUSED const uint32_t uid )
+{
+    return NULL;
+}
+void rofi_clear_error_messages ( void ) {}
+void rofi_add_error_message ( G_GNUC_UNUSED GString *msg )
+{
+}
+void rofi_set_return_code ( G_GNUC_UNUSED int code )
+{
+}
+gboolean rofi_theme_parse_string ( G_GNUC_UNUSED const char *string )
+{
+    return FALSE;
+}
+double textbox_get_estimated_char_height ( void )
+{
+    return 12.0;
+}
+double textbox_get_estimated_ch ( void )
+{
+    return 9.0;
+}
+void rofi_view_get_current_monitor ( int *width, int *height )
+{
+    *width  = 1920;
+    *height = 1080;
+}
+int monitor_active ( G_GNUC_UNUSED workarea *mon )
+{
+    return 0;
+}
+void display_startup_notification ( G_GNUC_UNUSED RofiHelperExecuteContext *context, G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup, G_GNUC_UNUSED gpointer *user_data )
+{
+}
+int rofi_view_error_dialog ( const char *msg, G_GNUC_UNUSED int markup )
+{
+    fputs ( msg, stderr );
+    return TRUE;
+}
+RofiViewState *rofi_view_create ( G_GNUC_UNUSED Mode *sw, G_GNUC_UNUSED const char *input, G_GNUC_UNUSED MenuFlags menu_flags, G_GNUC_UNUSED void ( *finalize )( RofiViewState * ) )
+{
+    return NULL;
+}
+MenuReturn rofi_view_get_return_value ( G_GNUC_UNUSED const RofiViewState *state )
+{
+    return 0;
+}
+unsigned int rofi_view_get_next_position ( G_GNUC_UNUSED const RofiViewState *state )
+{
+    return 0;
+}
+const char * rofi_view_get_user_input ( G_GNUC_UNUSED const RofiViewState *state )
+{
+    return NULL;
+}
+void rofi_view_set_selected_line ( G_GNUC_UNUSED RofiViewState *state, G_GNUC_UNUSED unsigned int selected_line )
+{
+}
+unsigned int rofi_view_get_selected_line ( G_GNUC_UNUSED const RofiViewState *state )
+{
+    return 0;
+}
+void rofi_view_restart ( G_GNUC_UNUSED RofiViewState *state )
+{
+}
+void rofi_view_free ( G_GNUC_UNUSED RofiViewState *state )
+{
+}
+RofiViewState * rofi_view_get_active ( void )
+{
+    return NULL;
+}
+void rofi_view_set_active ( G_GNUC_UNUSED RofiViewState *state )
+{
+}
+Mode * rofi_view_get_mode ( G_GNUC_UNUSED RofiViewState *state )
+{
+    return NULL;
+}
+void rofi_view_rows_added ( G_GNUC_UNUSED unsigned int start, G_GNUC_UNUSED unsigned int stop )
+{
+}
+void rofi_view_set_overlay ( G_GNUC_UNUSED RofiViewState *state, G_GNUC_UNUSED const char *text )
+{
+}
+void rofi_view_ellipsize_start ( G_GNUC_UNUSED RofiViewState *state )
+{
+}
+
+/**
+ * Capture every row the way the view reads it, then match them on the input.
+ * Without input nothing is printed, large inputs are only checked on the captured rows.
+ */
+unsigned int *rofi_view_filter_rows ( Mode *sw, const char *input, unsigned int *length )
+{
+    unsigned int     num     = mode_get_num_entries ( sw );
+    unsigned int     *rows   = g_malloc0_n ( num + 1, sizeof ( unsigned int ) );
+    rofi_int_matcher **tokens = helper_tokenize ( input != NULL ? input : "", config.case_sensitive );
+    *length = 0;
+    for ( unsigned int i = 0; i < num; i++ ) {
+        int        state = 0;
+        glong      slen  = 0;
+        const char *str  = mode_peek_completion ( sw, i, &slen );
+        if ( str != NULL ) {
+            g_ptr_array_add ( rows_text, g_strndup ( str, g_utf8_offset_to_pointer ( str, slen ) - str ) );
+        }
+        else {
+            g_ptr_array_add ( rows_text, mode_get_completion ( sw, i ) );
+        }
+        g_ptr_array_add ( rows_display, mode_get_display_value ( sw, i, &state, NULL, TRUE ) );
+        g_free ( icon_query );
+        icon_query = NULL;
+        mode_get_icon ( sw, i, 16 );
+        g_ptr_array_add ( rows_icon, g_strdup ( icon_query ) );
+        if ( input != NULL && mode_token_match ( sw, tokens, i ) ) {
+            rows[( *length )++] = i;
+        }
+    }
+    helper_tokenize_free ( tokens );
+    return rows;
+}
+
+static void test_call_thread ( gpointer data, gpointer user_data )
+{
+    thread_state *t = (thread_state *) data;
+    t->callback ( t, user_data );
+}
+
+static void dmenu_test_setup ( void )
+{
+    tpool        = g_thread_pool_new ( test_call_thread, NULL, 4, FALSE, NULL );
+    rows_text    = g_ptr_array_new_with_free_func ( g_free );
+    rows_display = g_ptr_array_new_with_free_func ( g_free );
+    rows_icon    = g_ptr_array_new_with_free_func ( g_free );
+}
+
+static void dmenu_test_teardown ( void )
+{
+    g_thread_pool_free ( tpool, FALSE, TRUE );
+    tpool = NULL;
+    g_ptr_array_free ( rows_text, TRUE );
+    g_ptr_array_free ( rows_display, TRUE );
+    g_ptr_array_free ( rows_icon, TRUE );
+    g_free ( icon_query );
+    icon_query = NULL;
+}
+
+/** Input on stdin, or mapped with -input. */
+#define DMENU_TEST_MAPPED     1
+/** Rows stored with -compact. */
+#define DMENU_TEST_COMPACT    2
+
+/**
+ * @param input The dmenu input.
+ * @param length The length of input.
+ * @param flags DMENU_TEST_MAPPED and DMENU_TEST_COMPACT.
+ * @param filter The filter to print the matching rows for, or NULL.
+ * @param ... Extra arguments, terminated by NULL.
+ *
+ * Run dmenu -filter-stdout. The rows read are put in rows_text, rows_display and rows_icon.
+ *
+ * @returns the printed rows, free with g_free.
+ */
+static char *run_dmenu ( const char *input, gsize length, int flags, const char *filter, ... )
+{
+    char *in_path  = NULL;
+    char *out_path = NULL;
+    int  in_fd     = g_file_open_tmp ( "rofi-dmenu-in-XXXXXX", &in_path, NULL );
+    int  out_fd    = g_file_open_tmp ( "rofi-dmenu-out-XXXXXX", &out_path, NULL );
+    ck_assert_int_ge ( in_fd, 0 );
+    ck_assert_int_ge ( out_fd, 0 );
+    close ( in_fd );
+    ck_assert ( g_file_set_contents ( in_path, input, length, NULL ) );
+    g_ptr_array_set_size ( rows_text, 0 );
+    g_ptr_array_set_size ( rows_display, 0 );
+    g_ptr_array_set_size ( rows_icon, 0 );
+
+    GPtrArray *args = g_ptr_array_new ();
+    g_ptr_array_add ( args, "rofi" );
+    g_ptr_array_add ( args, "-dmenu" );
+    va_list ap;
+    va_start ( ap, filter );
+    for ( char *arg = va_arg ( ap, char * ); arg != NULL; arg = va_arg ( ap, char * ) ) {
+        g_ptr_array_add ( args, arg );
+    }
+    va_end ( ap );
+    if ( flags & DMENU_TEST_COMPACT ) {
+        g_ptr_array_add ( args, "-compact" );
+    }
+    int stdin_fd = -1;
+    if ( flags & DMENU_TEST_MAPPED ) {
+        g_ptr_array_add ( args, "-input" );
+        g_ptr_array_add ( args, in_path );
+    }
+    else {
+        in_fd    = open ( in_path, O_RDONLY );
+        stdin_fd = dup ( STDIN_FILENO );
+        dup2 ( in_fd, STDIN_FILENO );
+        close ( in_fd );
+    }
+    g_ptr_array_add ( args, NULL );
+    cmd_set_arguments ( args->len - 1, (char * *) args->pdata );
+    config.filter = (char *) filter;
+
+    fflush ( stdout );
+    int stdout_fd = dup ( STDOUT_FILENO );
+    dup2 ( out_fd, STDOUT_FILENO );
+    close ( out_fd );
+    dmenu_filter_stdout ();
+    fflush ( stdout );
+    dup2 ( stdout_fd, STDOUT_FILENO );
+    close ( stdout_fd );
+    if ( stdin_fd >= 0 ) {
+        dup2 ( stdin_fd, STDIN_FILENO );
+        close ( stdin_fd );
+    }
+
+    char *output = NULL;
+    ck_assert ( g_file_get_contents ( out_path, &output, NULL, NULL ) );
+    config.filter = NULL;
+    cmd_set_arguments ( 0, NULL );
+    g_ptr_array_free ( args, TRUE );
+    g_unlink ( in_path );
+    g_unlink ( out_path );
+    g_free ( in_path );
+    g_free ( out_path );
+    return output;
+}
+
+#define ROW_TEXT( i )       ( (const char *) g_ptr_array_index ( rows_text, ( i ) ) )
+#define ROW_DISPLAY( i )    ( (const char *) g_ptr_array_index ( rows_display, ( i ) ) )
+#define ROW_ICON( i )       ( (const char *) g_ptr_array_index ( rows_icon, ( i ) ) )
+
+START_TEST ( test_dmenu_lines )
+{
+    static const char input[] = "aap\nnoot\nmies";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, "noot", NULL );
+    ck_assert_str_eq ( out, "noot\n" );
+    ck_assert_int_eq ( rows_text->len, 3 );
+    ck_assert_str_eq ( ROW_TEXT ( 0 ), "aap" );
+    ck_assert_str_eq ( ROW_TEXT ( 1 ), "noot" );
+    // The last line does not end on a separator.
+    ck_assert_str_eq ( ROW_TEXT ( 2 ), "mies" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 2 ), "mies" );
+    g_free ( out );
+
+    // A trailing separator does not add an empty row, empty lines are rows.
+    static const char empty[] = "aap\n\nmies\n";
+    out = run_dmenu ( empty, sizeof ( empty ) - 1, _i, "mies", NULL );
+    ck_assert_str_eq ( out, "mies\n" );
+    ck_assert_int_eq ( rows_text->len, 3 );
+    ck_assert_str_eq ( ROW_TEXT ( 1 ), "" );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_separator )
+{
+    static const char input[] = "aap|noot\nmies|zus";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, "zus", "-sep", "|", NULL );
+    ck_assert_str_eq ( out, "zus\n" );
+    ck_assert_int_eq ( rows_text->len, 3 );
+    ck_assert_str_eq ( ROW_TEXT ( 1 ), "noot\nmies" );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_extras )
+{
+    static const char input[] = "aap\0icon\x1f" "app-icon\x1fmeta\x1fmonkey\nnoot\0info\x1fsecret\nmies\0icon\x1flast";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, "monkey", NULL );
+    // Matched on the meta data, printed without the extras.
+    ck_assert_str_eq ( out, "aap\n" );
+    ck_assert_int_eq ( rows_text->len, 3 );
+    ck_assert_str_eq ( ROW_TEXT ( 0 ), "aap" );
+    ck_assert_str_eq ( ROW_TEXT ( 1 ), "noot" );
+    ck_assert_str_eq ( ROW_TEXT ( 2 ), "mies" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 0 ), "aap" );
+    ck_assert_str_eq ( ROW_ICON ( 0 ), "app-icon" );
+    ck_assert_ptr_null ( ROW_ICON ( 1 ) );
+    ck_assert_str_eq ( ROW_ICON ( 2 ), "last" );
+    g_free ( out );
+
+    // The extras are not matched as text.
+    out = run_dmenu ( input, sizeof ( input ) - 1, _i, "secret", NULL );
+    ck_assert_str_eq ( out, "" );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_invalid_utf8 )
+{
+    static const char input[] = "a\xff" "b\ngood\nc\xc3";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, "b", NULL );
+    ck_assert_str_eq ( out, "a\uFFFDb\n" );
+    ck_assert_int_eq ( rows_text->len, 3 );
+    ck_assert_str_eq ( ROW_TEXT ( 0 ), "a\uFFFDb" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 0 ), "a\uFFFDb" );
+    ck_assert_str_eq ( ROW_TEXT ( 1 ), "good" );
+    ck_assert_str_eq ( ROW_TEXT ( 2 ), "c\uFFFD" );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_markup )
+{
+    static const char input[] = "<b>bold</b>\nplain";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, "b>", "-markup-rows", NULL );
+    // Matched with the markup stripped.
+    ck_assert_str_eq ( out, "" );
+    ck_assert_str_eq ( ROW_TEXT ( 0 ), "bold" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 0 ), "<b>bold</b>" );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_columns )
+{
+    static const char input[] = "a\tb\tc\nx\ty\nsingle";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, "c", "-display-columns", "2,1", NULL );
+    // The full entry is printed.
+    ck_assert_str_eq ( out, "a\tb\tc\n" );
+    ck_assert_int_eq ( rows_display->len, 3 );
+    ck_assert_str_eq ( ROW_DISPLAY ( 0 ), "b\ta" );
+    // Like g_regex_split, the last piece is not a column.
+    ck_assert_str_eq ( ROW_DISPLAY ( 1 ), "x" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 2 ), "" );
+    g_free ( out );
+
+    // Only the displayed columns are matched.
+    out = run_dmenu ( input, sizeof ( input ) - 1, _i, "c", "-display-columns", "2,1", "-match-display-columns", NULL );
+    ck_assert_str_eq ( out, "" );
+    g_free ( out );
+    out = run_dmenu ( input, sizeof ( input ) - 1, _i, "b", "-display-columns", "2,1", "-match-display-columns", NULL );
+    ck_assert_str_eq ( out, "a\tb\tc\n" );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_columns_empty_match )
+{
+    // Empty separator matches split like g_regex_split: "ab,,c" on ",?" gives a, b, "", c.
+    static const char input[] = "ab,,c\nxy";
+    char              *out    = run_dmenu ( input, sizeof ( input ) - 1, _i, NULL, "-display-columns", "1,2,3,4", "-display-column-separator", ",?", NULL );
+    ck_assert_str_eq ( out, "" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 0 ), "a\tb\t" );
+    ck_assert_str_eq ( ROW_DISPLAY ( 1 ), "x" );
+    g_free ( out );
+
+    // Captured groups are columns of their own.
+    static const char groups[] = "a,b,c";
+    out = run_dmenu ( groups, sizeof ( groups ) - 1, _i, NULL, "-display-columns", "1,2,3,4", "-display-column-separator", "(,)", NULL );
+    ck_assert_str_eq ( ROW_DISPLAY ( 0 ), "a\t,\tb\t," );
+    g_free ( out );
+}
+END_TEST
+
+START_TEST ( test_dmenu_blocks )
+{
+    // Several parse blocks and many read chunks, with a line longer than a block.
+    GString   *input    = g_string_new ( NULL );
+    GPtrArray *expected = g_ptr_array_new_with_free_func ( g_free );
+    for ( unsigned int i = 0; i < 400000; i++ ) {
+        if ( i == 123456 ) {
+            char *line = g_strnfill ( 1536 * 1024, 'x' );
+            g_string_append ( input, line );
+            g_ptr_array_add ( expected, line );
+        }
+        else if ( ( i % 1000 ) == 7 ) {
+            g_string_append_printf ( input, "row %u", i );
+            g_string_append_len ( input, "\0meta\x1fm", 7 );
+            g_ptr_array_add ( expected, g_strdup_printf ( "row %u", i ) );
+        }
+        else if ( ( i % 1000 ) == 500 ) {
+            g_string_append_printf ( input, "bad\xff%u", i );
+            g_ptr_array_add ( expected, g_strdup_printf ( "bad\uFFFD%u", i ) );
+        }
+        else {
+            g_string_append_printf ( input, "row %u", i );
+            g_ptr_array_add ( expected, g_strdup_printf ( "row %u", i ) );
+        }
+        // The last line does not end on a separator.
+        if ( i + 1 < 400000 ) {
+            g_string_append_c ( input, '\n' );
+        }
+    }
+    char *out = run_dmenu ( input->str, input->len, _i, "399999", NULL );
+    ck_assert_str_eq ( out, "row 399999\n" );
+    ck_assert_int_eq ( rows_text->len, expected->len );
+    for ( unsigned int i = 0; i < expected->len; i++ ) {
+        ck_assert_str_eq ( ROW_TEXT ( i ), g_ptr_array_index ( expected, i ) );
+    }
+    g_free ( out );
+    g_ptr_array_free ( expected, TRUE );
+    g_string_free ( input, TRUE );
+}
+END_TEST
+
+static Suite * dmenu_suite ( void )
+{
+    Suite *s = suite_create ( "Dmenu" );
+
+    // Each test runs on stdin and mapped input, with and without -compact.
+    {
+        TCase *tc_input = tcase_create ( "Input" );
+        tcase_add_checked_fixture ( tc_input, dmenu_test_setup, dmenu_test_teardown );
+        tcase_add_loop_test ( tc_input, test_dmenu_lines, 0, 4 );
+        tcase_add_loop_test ( tc_input, test_dmenu_separator, 0, 4 );
+        tcase_add_loop_test ( tc_input, test_dmenu_extras, 0, 4 );
+        tcase_add_loop_test ( tc_input, test_dmenu_invalid_utf8, 0, 4 );
+        tcase_add_loop_test ( tc_input, test_dmenu_markup, 0, 4 );
+        suite_add_tcase ( s, tc_input );
+    }
+    {
+        TCase *tc_columns = tcase_create ( "Columns" );
+        tcase_add_checked_fixture ( tc_columns, dmenu_test_setup, dmenu_test_teardown );
+        tcase_add_loop_test ( tc_columns, test_dmenu_columns, 0, 4 );
+        tcase_add_loop_test ( tc_columns, test_dmenu_columns_empty_match, 0, 4 );
+        suite_add_tcase ( s, tc_columns );
+    }
+    {
+        TCase *tc_blocks = tcase_create ( "Blocks" );
+        tcase_add_checked_fixture ( tc_blocks, dmenu_test_setup, dmenu_test_teardown );
+        tcase_set_timeout ( tc_blocks, 60 );
+        tcase_add_loop_test ( tc_blocks, test_dmenu_blocks, 0, 4 );
+        suite_add_tcase ( s, tc_blocks );
+    }
+    return s;
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    if ( setlocale ( LC_ALL, "" ) == NULL ) {
+        fprintf ( stderr, "Failed to set locale.\n" );
+        return EXIT_FAILURE;
+    }
+
+    int     number_failed = 0;
+    Suite   *s;
+    SRunner *sr;
+
+    s  = dmenu_suite ();
+    sr = srunner_create ( s );
+
+    srunner_run_all ( sr, CK_NORMAL );
+    number_failed = srunner_ntests_failed ( sr );
+    srunner_free ( sr );
+    return ( number_failed == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,211 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2021 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <config.h>
+#include <locale.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "display.h"
+#include "theme.h"
+#include "xcb.h"
+#include "rofi.h"
+#include "settings.h"
+#include "rofi-types.h"
+#include "helper.h"
+#include "mode.h"
+#include "mode-private.h"
+#include "dialogs/drun.h"
+#include "rofi-icon-fetcher.h"
+
+#include <check.h>
+
+ThemeWidget *rofi_theme = NULL;
+const char  *cache_dir  = NULL;
+
+uint32_t rofi_icon_fetcher_query ( G_GNUC_UNUSED const char *name, G_GNUC_UNUSED const int size )
+{
+    return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced ( G_GNUC_UNUSED const char *name, G_GNUC_UNUSED const int wsize, G_GNUC_UNUSED const int hsize )
+{
+    return 0;
+}
+cairo_surface_t * rofi_icon_fetcher_get ( G_GNUC_UNUSED const uint32_t uid )
+{
+    return NULL;
+}
+gboolean rofi_icon_fetcher_file_is_image ( G_GNUC_UNUSED const char * const path )
+{
+    return FALSE;
+}
+void rofi_clear_error_messages ( void ) {}
+void rofi_add_error_message ( G_GNUC_UNUSED GString *msg )
+{
+}
+gboolean rofi_theme_parse_string ( G_GNUC_UNUSED const char *string )
+{
+    return FALSE;
+}
+int monitor_active ( G_GNUC_UNUSED workarea *mon )
+{
+    return 0;
+}
+int rofi_view_error_dialog ( const char *msg, G_GNUC_UNUSED int markup )
+{
+    fputs ( msg, stderr );
+    return TRUE;
+}
+void display_startup_notification ( G_GNUC_UNUSED RofiHelperExecuteContext *context, G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup, G_GNUC_UNUSED gpointer *user_data )
+{
+}
+
+#ifdef ENABLE_DRUN
+/** The directory with the desktop files and the cache. */
+static char *test_dir = NULL;
+
+/**
+ * @param input The tokens
+ *
+ * @returns TRUE when the desktop entry matches the tokens.
+ */
+static int drun_match ( const char *input )
+{
+    rofi_int_matcher **tokens = helper_tokenize ( input, FALSE );
+    int              retv     = mode_token_match ( &drun_mode, tokens, 0 );
+    helper_tokenize_free ( tokens );
+    return retv;
+}
+
+static void drun_setup ( void )
+{
+    test_dir  = g_dir_make_tmp ( "rofi-drun-test-XXXXXX", NULL );
+    cache_dir = test_dir;
+    char *user = g_build_filename ( test_dir, "user", "applications", NULL );
+    char *sys  = g_build_filename ( test_dir, "system", NULL );
+    char *path = g_build_filename ( user, "test.desktop", NULL );
+    g_mkdir_with_parents ( user, 0700 );
+    g_mkdir_with_parents ( sys, 0700 );
+    g_file_set_contents ( path,
+                          "[Desktop Entry]\n"
+                          "Type=Application\n"
+                          "Name=Aap Editor\n"
+                          "Exec=noot\n"
+                          "Keywords=mies;\n", -1, NULL );
+    g_free ( path );
+    g_free ( user );
+
+    // Only the test directories are read.
+    char *data = g_build_filename ( test_dir, "user", NULL );
+    g_setenv ( "XDG_DATA_HOME", data, TRUE );
+    g_setenv ( "XDG_DATA_DIRS", sys, TRUE );
+    g_unsetenv ( "XDG_CURRENT_DESKTOP" );
+    g_free ( data );
+    g_free ( sys );
+
+    config.matching_method = MM_NORMAL;
+    ck_assert_int_eq ( mode_init ( &drun_mode ), TRUE );
+    ck_assert_int_eq ( mode_get_num_entries ( &drun_mode ), 1 );
+}
+
+static void drun_teardown ( void )
+{
+    mode_destroy ( &drun_mode );
+    char *path = g_build_filename ( test_dir, "user", "applications", "test.desktop", NULL );
+    g_unlink ( path );
+    g_free ( path );
+    path = g_build_filename ( test_dir, "user", "applications", NULL );
+    g_rmdir ( path );
+    g_free ( path );
+    path = g_build_filename ( test_dir, "user", NULL );
+    g_rmdir ( path );
+    g_free ( path );
+    path = g_build_filename ( test_dir, "system", NULL );
+    g_rmdir ( path );
+    g_free ( path );
+    g_rmdir ( test_dir );
+    g_free ( test_dir );
+    test_dir  = NULL;
+    cache_dir = NULL;
+}
+
+START_TEST ( test_drun_match_fields )
+{
+    // Each token can match a different field.
+    ck_assert_int_eq ( drun_match ( "mies" ), TRUE );
+    ck_assert_int_eq ( drun_match ( "editor noot" ), TRUE );
+    ck_assert_int_eq ( drun_match ( "editor vuur" ), FALSE );
+    ck_assert_int_eq ( drun_match ( "-mies" ), FALSE );
+    ck_assert_int_eq ( drun_match ( "-vuur aap" ), TRUE );
+}
+END_TEST
+
+START_TEST ( test_drun_match_field_boundary )
+{
+    // A token never matches across two fields.
+    ck_assert_int_eq ( drun_match ( "editornoot" ), FALSE );
+    config.matching_method = MM_FUZZY;
+    ck_assert_int_eq ( drun_match ( "ornoot" ), FALSE );
+    ck_assert_int_eq ( drun_match ( "aed" ), TRUE );
+    config.matching_method = MM_REGEX;
+    ck_assert_int_eq ( drun_match ( "editor\\snoot" ), FALSE );
+    ck_assert_int_eq ( drun_match ( "^noot$" ), TRUE );
+    config.matching_method = MM_NORMAL;
+}
+END_TEST
+
+#endif // ENABLE_DRUN
+
+static Suite * drun_suite ( void )
+{
+    Suite *s = suite_create ( "DRun" );
+#ifdef ENABLE_DRUN
+    TCase *tc_match = tcase_create ( "Match" );
+    // The data dirs are looked up once by glib, set them up once.
+    tcase_add_unchecked_fixture ( tc_match, drun_setup, drun_teardown );
+    tcase_add_test ( tc_match, test_drun_match_fields );
+    tcase_add_test ( tc_match, test_drun_match_field_boundary );
+    suite_add_tcase ( s, tc_match );
+#endif
+    return s;
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    if ( setlocale ( LC_ALL, "" ) == NULL ) {
+        fprintf ( stderr, "Failed to set locale.\n" );
+        return EXIT_FAILURE;
+    }
+    Suite   *s  = drun_suite ();
+    SRunner *sr = srunner_create ( s );
+    srunner_run_all ( sr, CK_NORMAL );
+    int number_failed = srunner_ntests_failed ( sr );
+    srunner_free ( sr );
+    return ( number_failed == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
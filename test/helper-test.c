@@ -157,6 +157,15 @@ int main ( int argc, char ** argv )
     TASSERTE ( levenshtein ( "aap", g_utf8_strlen ( "aap", -1), "noot aap mies", g_utf8_strlen ( "noot aap mies", -1) ), 10u );
     TASSERTE ( levenshtein ( "noot aap mies", g_utf8_strlen ( "noot aap mies", -1), "aap", g_utf8_strlen ( "aap", -1) ), 10u );
     TASSERTE ( levenshtein ( "otp", g_utf8_strlen ( "otp", -1), "noot aap", g_utf8_strlen ( "noot aap", -1) ), 5u );
+    {
+        // Patterns over 64 characters span multiple words of the bit-parallel distance.
+        const char *l1 = "aap noot mies wim zus jet teun vuur gijs lam kees bok weide does hok duif schapen aap noot";
+        const char *l2 = "aap noot mies wim zus jet teun vuur gijs lam kees bok weide does hok duif schaap aap noot";
+        TASSERTE ( levenshtein ( l1, g_utf8_strlen ( l1, -1), l1, g_utf8_strlen ( l1, -1) ), 0u );
+        TASSERTE ( levenshtein ( l1, g_utf8_strlen ( l1, -1), l2, g_utf8_strlen ( l2, -1) ), 3u );
+        TASSERTE ( levenshtein ( l2, g_utf8_strlen ( l2, -1), "aap", g_utf8_strlen ( "aap", -1) ), 86u );
+        TASSERTE ( levenshtein ( "AAP éé", g_utf8_strlen ( "AAP éé", -1), "aap ÉÉ", g_utf8_strlen ( "aap ÉÉ", -1) ), 0u );
+    }
     /**
      * Quick converision check.
      */
@@ -190,10 +199,23 @@ int main ( int argc, char ** argv )
         TASSERTL ( rofi_scorer_fuzzy_evaluate ("anm", 3, "aap noot mies", 12), -155);
         TASSERTL ( rofi_scorer_fuzzy_evaluate ("blu", 3, "aap noot mies", 12), 1073741824);
         config.case_sensitive = TRUE;
-        TASSERTL ( rofi_scorer_fuzzy_evaluate ("Anm", 3, "aap noot mies", 12), 1073741754);
+        TASSERTL ( rofi_scorer_fuzzy_evaluate ("Anm", 3, "aap noot mies", 12), 1073741824);
         config.case_sensitive = FALSE;
         TASSERTL ( rofi_scorer_fuzzy_evaluate ("Anm", 3, "aap noot mies", 12), -155);
         TASSERTL ( rofi_scorer_fuzzy_evaluate ("aap noot mies", 12,"Anm", 3 ), 1073741824);
+        // Entries over 256 characters are scored too.
+        char long_str[301];
+        memset ( long_str, 'x', 300 );
+        memcpy ( long_str, "aap ", 4 );
+        memcpy ( long_str + 290, "noot", 4 );
+        long_str[300] = '\0';
+        TASSERTL ( rofi_scorer_fuzzy_evaluate ("aap", 3, long_str, 300), 1295);
+        TASSERTL ( rofi_scorer_fuzzy_evaluate ("noot", 4, long_str, 300), 1055);
+        unsigned int max_length = config.sorting_max_length;
+        config.sorting_max_length = 8;
+        TASSERTL ( rofi_scorer_fuzzy_evaluate ("noot", 4, long_str, 300), 1045);
+        TASSERTL ( rofi_scorer_fuzzy_evaluate ("aap noot", 8, long_str, 300), 1073741824);
+        config.sorting_max_length = max_length;
 
     }
 
@@ -342,6 +342,265 @@ START_TEST ( test_tokenizer_match_fuzzy_multiple_ci_split )
 }
 END_TEST
 
+START_TEST ( test_tokenizer_match_fuzzy_single_ci_newline )
+{
+    config.matching_method = MM_FUZZY;
+    rofi_int_matcher **tokens = helper_tokenize ( "nt", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "noot") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "noo\nt") , FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "noo\nnoot") , TRUE );
+    helper_tokenize_free ( tokens );
+}
+END_TEST
+
+START_TEST ( test_tokenizer_match_prefix_single_ci )
+{
+    config.matching_method = MM_PREFIX;
+    rofi_int_matcher **tokens = helper_tokenize ( "noot", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap noot mies") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aapnoot mies") , FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aapnoot noOTmies") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "Noot") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap-noot") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap_noot") , FALSE );
+    helper_tokenize_free ( tokens );
+}
+END_TEST
+
+START_TEST ( test_tokenizer_match_prefix_single_cs )
+{
+    config.matching_method = MM_PREFIX;
+    rofi_int_matcher **tokens = helper_tokenize ( "noot", TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap noot mies") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap Noot mies") , FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "Noot noot") , TRUE );
+    helper_tokenize_free ( tokens );
+}
+END_TEST
+
+START_TEST ( test_tokenizer_match_normal_single_ci_utf8 )
+{
+    config.matching_method = MM_NORMAL;
+    rofi_int_matcher **tokens = helper_tokenize ( "élan", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap ÉLAN mies") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap elan mies") , FALSE );
+    helper_tokenize_free ( tokens );
+}
+END_TEST
+
+START_TEST ( test_tokenizer_match_normal_single_ci_fold )
+{
+    config.matching_method = MM_NORMAL;
+    // Folded like a caseless regex: all sigmas are equal, KELVIN SIGN matches k.
+    rofi_int_matcher **tokens = helper_tokenize ( "σοφος", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap ΣΟΦΟΣ mies") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap σοφοσ mies") , TRUE );
+    helper_tokenize_free ( tokens );
+    tokens = helper_tokenize ( "kat", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap \u212Aat mies") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap kkkaat KAT") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "aap kkkaa") , FALSE );
+    helper_tokenize_free ( tokens );
+    // The dotted and dotless i only match themselves.
+    tokens = helper_tokenize ( "i", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "\u0130\u0131") , FALSE );
+    helper_tokenize_free ( tokens );
+    // Tokens that need full case folding are matched by the regex.
+    tokens = helper_tokenize ( "straße", FALSE );
+    ck_assert_ptr_ne ( tokens[0]->regex, NULL );
+    ck_assert_int_eq ( helper_token_match ( tokens, "STRA\u1E9EE") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "strasse") , FALSE );
+    helper_tokenize_free ( tokens );
+    config.matching_method = MM_PREFIX;
+    tokens                 = helper_tokenize ( "straße", FALSE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "de STRA\u1E9EE") , TRUE );
+    ck_assert_int_eq ( helper_token_match ( tokens, "destraße") , FALSE );
+    helper_tokenize_free ( tokens );
+    config.matching_method = MM_NORMAL;
+}
+END_TEST
+
+START_TEST ( test_tokenizer_match_cache_ci )
+{
+    config.matching_method = MM_NORMAL;
+    config.case_sensitive  = FALSE;
+    RofiMatchCache *cache = helper_match_cache_new ();
+    ck_assert_ptr_ne ( cache, NULL );
+    helper_match_cache_add ( cache, "aap NOOT mies", -1 );
+    helper_match_cache_add ( cache, NULL, -1 );
+    helper_match_cache_add ( cache, "aap mies", -1 );
+    ck_assert_str_eq ( helper_match_cache_get ( cache, 0 ), "aap noot mies" );
+    ck_assert_ptr_eq ( helper_match_cache_get ( cache, 1 ), NULL );
+
+    rofi_int_matcher **tokens = helper_tokenize ( "Noot", FALSE );
+    ck_assert_int_eq ( helper_match_cache_usable ( cache, tokens, 0 ), TRUE );
+    ck_assert_int_eq ( helper_match_cache_usable ( cache, tokens, 3 ), FALSE );
+    ck_assert_int_eq ( helper_match_cache_token_match ( cache, tokens, 0 ), TRUE );
+    ck_assert_int_eq ( helper_match_cache_token_match ( cache, tokens, 1 ), FALSE );
+    ck_assert_int_eq ( helper_match_cache_token_match ( cache, tokens, 2 ), FALSE );
+    helper_tokenize_free ( tokens );
+
+    tokens = helper_tokenize ( "noot", TRUE );
+    ck_assert_int_eq ( helper_match_cache_usable ( cache, tokens, 0 ), FALSE );
+    helper_tokenize_free ( tokens );
+
+    const RofiStringTable *table = helper_match_cache_get_table ( cache );
+    ck_assert_int_eq ( table->length, 3 );
+    ck_assert_int_eq ( table->lengths[0], 13 );
+    ck_assert_int_eq ( table->lengths[2], 8 );
+    ck_assert_str_eq ( table->strings[2], "aap mies" );
+    helper_match_cache_free ( cache );
+
+    // Case sensitive, the strings are used as they are, not copied.
+    const char *str = "aap NOOT mies";
+    config.case_sensitive = TRUE;
+    cache                 = helper_match_cache_new ();
+    helper_match_cache_add ( cache, str, -1 );
+    ck_assert_ptr_eq ( helper_match_cache_get ( cache, 0 ), str );
+    ck_assert_int_eq ( helper_match_cache_get_table ( cache )->lengths[0], 13 );
+    tokens = helper_tokenize ( "NOOT", TRUE );
+    ck_assert_int_eq ( helper_match_cache_usable ( cache, tokens, 0 ), TRUE );
+    ck_assert_int_eq ( helper_string_table_token_match ( helper_match_cache_get_table ( cache ), tokens, 0 ), TRUE );
+    helper_tokenize_free ( tokens );
+    helper_match_cache_free ( cache );
+    config.case_sensitive = FALSE;
+}
+END_TEST
+
+START_TEST ( test_tokenizer_match_slice )
+{
+    // Rows used in place are not terminated, only the given length is matched.
+    const char *str = "aap noot\nmies";
+    config.matching_method = MM_NORMAL;
+    rofi_int_matcher **tokens = helper_tokenize ( "mies", FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, str, 8 ), FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, str, -1 ), TRUE );
+    helper_tokenize_free ( tokens );
+    tokens = helper_tokenize ( "noot", FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, str, 7 ), FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, str, 8 ), TRUE );
+    helper_tokenize_free ( tokens );
+
+    config.matching_method = MM_FUZZY;
+    tokens                 = helper_tokenize ( "amies", FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, "aap mies", 7 ), FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, "aap mies", 8 ), TRUE );
+    helper_tokenize_free ( tokens );
+
+    config.matching_method = MM_REGEX;
+    tokens                 = helper_tokenize ( "mies$", FALSE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, "aap mies noot", 8 ), TRUE );
+    ck_assert_int_eq ( helper_token_match_len ( tokens, "aap mies noot", -1 ), FALSE );
+    helper_tokenize_free ( tokens );
+
+    // The cache refers to the slice, and matches only its length.
+    config.matching_method = MM_NORMAL;
+    config.case_sensitive  = TRUE;
+    RofiMatchCache *cache = helper_match_cache_new ();
+    helper_match_cache_add ( cache, str, 8 );
+    ck_assert_ptr_eq ( helper_match_cache_get ( cache, 0 ), str );
+    ck_assert_int_eq ( helper_match_cache_get_table ( cache )->lengths[0], 8 );
+    tokens = helper_tokenize ( "mies", TRUE );
+    ck_assert_int_eq ( helper_match_cache_token_match ( cache, tokens, 0 ), FALSE );
+    helper_tokenize_free ( tokens );
+    helper_match_cache_free ( cache );
+
+    // Folded, the copy holds the slice only.
+    config.case_sensitive = FALSE;
+    cache                 = helper_match_cache_new ();
+    helper_match_cache_add ( cache, "AAP NOOT", 3 );
+    ck_assert_str_eq ( helper_match_cache_get ( cache, 0 ), "aap" );
+    helper_match_cache_free ( cache );
+    config.matching_method = MM_NORMAL;
+}
+END_TEST
+
+static const char *trigram_rows[] = { "aap NOOT mies", "Noten", "aap mies", "aapnoot", "" };
+
+static const char *trigram_get_string ( G_GNUC_UNUSED gpointer data, unsigned int index, unsigned int field, gsize *length )
+{
+    if ( field != 0 ) {
+        return NULL;
+    }
+    *length = strlen ( trigram_rows[index] );
+    return trigram_rows[index];
+}
+
+START_TEST ( test_tokenizer_trigram_index )
+{
+    config.matching_method = MM_NORMAL;
+    RofiTrigramIndex *index = helper_trigram_index_new ( 5, trigram_get_string, NULL, NULL );
+    ck_assert_ptr_ne ( index, NULL );
+
+    unsigned int     length      = 0;
+    rofi_int_matcher **tokens    = helper_tokenize ( "noot aap", FALSE );
+    unsigned int     *candidates = helper_trigram_index_candidates ( index, tokens, &length );
+    ck_assert_ptr_ne ( candidates, NULL );
+    ck_assert_int_eq ( length, 2 );
+    ck_assert_int_eq ( candidates[0], 0 );
+    ck_assert_int_eq ( candidates[1], 3 );
+    g_free ( candidates );
+    helper_tokenize_free ( tokens );
+
+    // Case sensitive tokens are looked up folded, the match sorts out the case.
+    tokens     = helper_tokenize ( "NOT", TRUE );
+    candidates = helper_trigram_index_candidates ( index, tokens, &length );
+    ck_assert_int_eq ( length, 1 );
+    ck_assert_int_eq ( candidates[0], 1 );
+    g_free ( candidates );
+    helper_tokenize_free ( tokens );
+
+    tokens     = helper_tokenize ( "wim", FALSE );
+    candidates = helper_trigram_index_candidates ( index, tokens, &length );
+    ck_assert_ptr_ne ( candidates, NULL );
+    ck_assert_int_eq ( length, 0 );
+    g_free ( candidates );
+    helper_tokenize_free ( tokens );
+
+    // Short and negated tokens rule out nothing.
+    tokens = helper_tokenize ( "no -aap", FALSE );
+    ck_assert_ptr_eq ( helper_trigram_index_candidates ( index, tokens, &length ), NULL );
+    helper_tokenize_free ( tokens );
+
+    config.matching_method = MM_REGEX;
+    tokens                 = helper_tokenize ( "noot", FALSE );
+    ck_assert_ptr_eq ( helper_trigram_index_candidates ( index, tokens, &length ), NULL );
+    helper_tokenize_free ( tokens );
+    config.matching_method = MM_NORMAL;
+
+    helper_trigram_index_free ( index );
+}
+END_TEST
+
+START_TEST ( test_tokenizer_matcher_cache )
+{
+    config.matching_method = MM_NORMAL;
+    rofi_int_matcher **tokens  = helper_tokenize ( "noot aap", FALSE );
+    rofi_int_matcher **tokens2 = helper_tokenize ( "noot aap mies", FALSE );
+    // Unchanged tokens are shared.
+    ck_assert_ptr_eq ( tokens[0], tokens2[0] );
+    ck_assert_ptr_eq ( tokens[1], tokens2[1] );
+    helper_tokenize_free ( tokens );
+    ck_assert_int_eq ( helper_token_match ( tokens2, "aap noot mies" ), TRUE );
+    helper_tokenize_free ( tokens2 );
+
+    // Changed settings create a new matcher.
+    tokens  = helper_tokenize ( "noot", FALSE );
+    tokens2 = helper_tokenize ( "noot", TRUE );
+    ck_assert_ptr_ne ( tokens[0], tokens2[0] );
+    helper_tokenize_free ( tokens2 );
+    config.matching_method = MM_FUZZY;
+    tokens2                = helper_tokenize ( "noot", FALSE );
+    ck_assert_ptr_ne ( tokens[0], tokens2[0] );
+    ck_assert_int_eq ( tokens2[0]->method, MM_FUZZY );
+    helper_tokenize_free ( tokens2 );
+    helper_tokenize_free ( tokens );
+    config.matching_method = MM_NORMAL;
+
+    helper_tokenize_cache_clear ();
+}
+END_TEST
+
 START_TEST ( test_tokenizer_match_regex_single_ci )
 {
     config.matching_method = MM_REGEX;
@@ -388,6 +647,34 @@ START_TEST ( test_tokenizer_match_regex_multiple_ci )
 }
 END_TEST
 
+START_TEST ( test_tokenizer_match_cache_regex_cs )
+{
+    // Case sensitive regex and glob tokens cannot be matched against folded strings.
+    const char *patterns[] = { "NOOT", "N?OT" };
+    const int  methods[]   = { MM_REGEX, MM_GLOB };
+    config.case_sensitive = FALSE;
+    RofiMatchCache *cache = helper_match_cache_new ();
+    helper_match_cache_add ( cache, "aap NOOT mies", -1 );
+    helper_match_cache_add ( cache, "aap noot mies", -1 );
+    for ( int i = 0; i < 2; i++ ) {
+        config.matching_method = methods[i];
+        rofi_int_matcher **tokens = helper_tokenize ( patterns[i], TRUE );
+        ck_assert_int_eq ( helper_match_cache_usable ( cache, tokens, 0 ), FALSE );
+        ck_assert_int_eq ( helper_token_match ( tokens, "aap NOOT mies" ), TRUE );
+        ck_assert_int_eq ( helper_token_match ( tokens, "aap noot mies" ), FALSE );
+        helper_tokenize_free ( tokens );
+
+        tokens = helper_tokenize ( patterns[i], FALSE );
+        ck_assert_int_eq ( helper_match_cache_usable ( cache, tokens, 0 ), TRUE );
+        ck_assert_int_eq ( helper_match_cache_token_match ( cache, tokens, 0 ), TRUE );
+        ck_assert_int_eq ( helper_match_cache_token_match ( cache, tokens, 1 ), TRUE );
+        helper_tokenize_free ( tokens );
+    }
+    helper_match_cache_free ( cache );
+    config.matching_method = MM_NORMAL;
+}
+END_TEST
+
 START_TEST ( test_tokenizer_match_regex_single_ci_dq )
 {
     config.matching_method = MM_REGEX;
@@ -429,6 +716,35 @@ START_TEST ( test_tokenizer_match_regex_single_two_word_till_end )
 }
 END_TEST
 
+START_TEST ( test_tokenizer_match_get_ranges )
+{
+    config.matching_method = MM_NORMAL;
+    ck_assert_ptr_eq ( helper_token_match_get_ranges ( NULL, "aap noot" ), NULL );
+
+    // Every hit is returned, negated tokens are not highlighted.
+    rofi_int_matcher **tokens = helper_tokenize ( "noot -aap", FALSE );
+    GArray            *ranges = helper_token_match_get_ranges ( tokens, "aap noot Noot" );
+    ck_assert_int_eq ( ranges->len, 2 );
+    ck_assert_int_eq ( g_array_index ( ranges, rofi_range_pair, 0 ).start, 4 );
+    ck_assert_int_eq ( g_array_index ( ranges, rofi_range_pair, 0 ).stop, 8 );
+    ck_assert_int_eq ( g_array_index ( ranges, rofi_range_pair, 1 ).start, 9 );
+    ck_assert_int_eq ( g_array_index ( ranges, rofi_range_pair, 1 ).stop, 13 );
+    g_array_free ( ranges, TRUE );
+    helper_tokenize_free ( tokens );
+
+    // A regex highlights its groups.
+    config.matching_method = MM_REGEX;
+    tokens                 = helper_tokenize ( "n(o+)t", FALSE );
+    ranges                 = helper_token_match_get_ranges ( tokens, "aap noot" );
+    ck_assert_int_eq ( ranges->len, 1 );
+    ck_assert_int_eq ( g_array_index ( ranges, rofi_range_pair, 0 ).start, 5 );
+    ck_assert_int_eq ( g_array_index ( ranges, rofi_range_pair, 0 ).stop, 7 );
+    g_array_free ( ranges, TRUE );
+    helper_tokenize_free ( tokens );
+    config.matching_method = MM_NORMAL;
+}
+END_TEST
+
 static Suite * helper_tokenizer_suite (void)
 {
     Suite *s;
@@ -449,6 +765,12 @@ static Suite * helper_tokenizer_suite (void)
         tcase_add_test(tc_normal, test_tokenizer_match_normal_multiple_ci );
         tcase_add_test(tc_normal, test_tokenizer_match_normal_single_ci_negate );
         tcase_add_test(tc_normal, test_tokenizer_match_normal_multiple_ci_negate);
+        tcase_add_test(tc_normal, test_tokenizer_match_normal_single_ci_utf8);
+        tcase_add_test(tc_normal, test_tokenizer_match_normal_single_ci_fold);
+        tcase_add_test(tc_normal, test_tokenizer_match_cache_ci);
+        tcase_add_test(tc_normal, test_tokenizer_match_slice);
+        tcase_add_test(tc_normal, test_tokenizer_trigram_index);
+        tcase_add_test(tc_normal, test_tokenizer_matcher_cache);
         suite_add_tcase(s, tc_normal);
     }
     {
@@ -468,8 +790,15 @@ static Suite * helper_tokenizer_suite (void)
         tcase_add_test(tc_fuzzy, test_tokenizer_match_fuzzy_single_ci_split);
         tcase_add_test(tc_fuzzy, test_tokenizer_match_fuzzy_multiple_ci);
         tcase_add_test(tc_fuzzy, test_tokenizer_match_fuzzy_multiple_ci_split);
+        tcase_add_test(tc_fuzzy, test_tokenizer_match_fuzzy_single_ci_newline);
         suite_add_tcase(s, tc_fuzzy);
     }
+    {
+        TCase *tc_prefix = tcase_create ("Prefix");
+        tcase_add_test(tc_prefix, test_tokenizer_match_prefix_single_ci);
+        tcase_add_test(tc_prefix, test_tokenizer_match_prefix_single_cs);
+        suite_add_tcase(s, tc_prefix);
+    }
     {
         TCase *tc_regex = tcase_create ("Regex");
         tcase_add_test(tc_regex, test_tokenizer_match_regex_single_ci);
@@ -478,8 +807,14 @@ static Suite * helper_tokenizer_suite (void)
         tcase_add_test(tc_regex, test_tokenizer_match_regex_single_two_char);
         tcase_add_test(tc_regex, test_tokenizer_match_regex_single_two_word_till_end);
         tcase_add_test(tc_regex, test_tokenizer_match_regex_multiple_ci);
+        tcase_add_test(tc_regex, test_tokenizer_match_cache_regex_cs);
         suite_add_tcase(s, tc_regex);
     }
+    {
+        TCase *tc_ranges = tcase_create ("Ranges");
+        tcase_add_test(tc_ranges, test_tokenizer_match_get_ranges);
+        suite_add_tcase(s, tc_ranges);
+    }
 
 
     return s;
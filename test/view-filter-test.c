@@ -0,0 +1,761 @@
+/*
+ * rofi
+ *
+ * MIT/X11 License
+ * Copyright © 2013-2021 Qball Cow <qball@gmpclient.org>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <assert.h>
+#include <locale.h>
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xcb/xcb_ewmh.h>
+#include "display.h"
+#include "theme.h"
+#include "xcb.h"
+#include "xcb-internal.h"
+#include "rofi.h"
+#include "settings.h"
+#include "rofi-types.h"
+#include "helper.h"
+#include "mode.h"
+#include "mode-private.h"
+#include "view.h"
+#include "view-internal.h"
+#include "rofi-icon-fetcher.h"
+
+#include <check.h>
+
+ThemeWidget *rofi_theme = NULL;
+
+/** Number of rows of the test mode. */
+#define NUM_ROWS    20000
+
+/** The rows of the test mode. */
+static GPtrArray      *test_rows        = NULL;
+/** Number of rows matched through the mode. (atomic) */
+static gint           test_match_calls = 0;
+/** Number of rows copied by the mode. (atomic) */
+static gint           test_copy_calls  = 0;
+/** Number of batches matched through the mode. (atomic) */
+static gint           test_batch_calls = 0;
+/** The folded rows, exported as string table when set. */
+static RofiMatchCache *test_match_cache = NULL;
+/** Stands in for the window, the theme is looked up on its name. */
+static widget         test_window;
+
+uint32_t rofi_icon_fetcher_query ( G_GNUC_UNUSED const char *name, G_GNUC_UNUSED const int size )
+{
+    return 0;
+}
+uint32_t rofi_icon_fetcher_query_advanced ( G_GNUC_UNUSED const char *name, G_GNUC_UNUSED const int wsize, G_GNUC_UNUSED const int hsize )
+{
+    return 0;
+}
+cairo_surface_t * rofi_icon_fetcher_get ( G_GNUC_UNUSED const uint32_t uid )
+{
+    return NULL;
+}
+void rofi_clear_error_messages ( void ) {}
+void rofi_add_error_message ( G_GNUC_UNUSED GString *msg )
+{
+}
+gboolean rofi_theme_parse_string ( G_GNUC_UNUSED const char *string )
+{
+    return FALSE;
+}
+double textbox_get_estimated_char_height ( void )
+{
+    return 12.0;
+}
+double textbox_get_estimated_ch ( void )
+{
+    return 9.0;
+}
+int monitor_active ( G_GNUC_UNUSED workarea *mon )
+{
+    return 0;
+}
+void display_startup_notification ( G_GNUC_UNUSED RofiHelperExecuteContext *context, G_GNUC_UNUSED GSpawnChildSetupFunc *child_setup, G_GNUC_UNUSED gpointer *user_data )
+{
+}
+void display_early_cleanup ( void )
+{
+}
+void process_result ( G_GNUC_UNUSED RofiViewState *state )
+{
+}
+const Mode * rofi_get_mode ( G_GNUC_UNUSED unsigned int index )
+{
+    return NULL;
+}
+unsigned int rofi_get_num_enabled_modi ( void )
+{
+    return 0;
+}
+void rofi_quit_main_loop ( void )
+{
+}
+guint key_binding_get_action_from_name ( G_GNUC_UNUSED const char *name )
+{
+    return UINT32_MAX;
+}
+
+/* There is no X server, the view runs without windows. */
+xcb_stuff        *xcb    = NULL;
+xcb_depth_t      *depth  = NULL;
+xcb_visualtype_t *visual = NULL;
+xcb_colormap_t   map     = XCB_COLORMAP_NONE;
+xcb_atom_t       netatoms[NUM_NETATOMS];
+
+void rofi_xcb_set_input_focus ( G_GNUC_UNUSED xcb_window_t w )
+{
+}
+void rofi_xcb_revert_input_focus ( void )
+{
+}
+void window_set_atom_prop ( G_GNUC_UNUSED xcb_window_t w, G_GNUC_UNUSED xcb_atom_t prop, G_GNUC_UNUSED xcb_atom_t *atoms, G_GNUC_UNUSED int count )
+{
+}
+void x11_disable_decoration ( G_GNUC_UNUSED xcb_window_t window )
+{
+}
+void x11_set_cursor ( G_GNUC_UNUSED xcb_window_t window, G_GNUC_UNUSED X11CursorType type )
+{
+}
+cairo_surface_t * x11_helper_get_bg_surface ( void )
+{
+    return NULL;
+}
+cairo_surface_t *x11_helper_get_screenshot_surface ( void )
+{
+    return NULL;
+}
+
+/* The widgets are not drawn, the view state holds the filter result. */
+box * box_create ( G_GNUC_UNUSED widget *parent, G_GNUC_UNUSED const char *name, G_GNUC_UNUSED RofiOrientation type )
+{
+    return NULL;
+}
+void box_add ( G_GNUC_UNUSED box *box, G_GNUC_UNUSED widget *child, G_GNUC_UNUSED gboolean expand )
+{
+}
+container * container_create ( G_GNUC_UNUSED widget *parent, G_GNUC_UNUSED const char *name )
+{
+    return NULL;
+}
+void container_add ( G_GNUC_UNUSED container *container, G_GNUC_UNUSED widget *child )
+{
+}
+icon * icon_create ( G_GNUC_UNUSED widget *parent, G_GNUC_UNUSED const char *name )
+{
+    return NULL;
+}
+void icon_set_surface ( G_GNUC_UNUSED icon *icon, G_GNUC_UNUSED cairo_surface_t *surf )
+{
+}
+listview *listview_create ( G_GNUC_UNUSED widget *parent, G_GNUC_UNUSED const char *name, G_GNUC_UNUSED listview_update_callback cb, G_GNUC_UNUSED void *udata, G_GNUC_UNUSED unsigned int eh, G_GNUC_UNUSED gboolean reverse )
+{
+    return NULL;
+}
+gboolean listview_get_fixed_num_lines ( G_GNUC_UNUSED listview *lv )
+{
+    return FALSE;
+}
+unsigned int listview_get_selected ( G_GNUC_UNUSED listview *lv )
+{
+    return 0;
+}
+void listview_nav_down ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_nav_left ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_nav_page_next ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_nav_page_prev ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_nav_right ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_nav_up ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_set_ellipsize_start ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_set_fixed_num_lines ( G_GNUC_UNUSED listview *lv )
+{
+}
+void listview_set_max_lines ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED unsigned int max_lines )
+{
+}
+void listview_set_mouse_activated_cb ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED listview_mouse_activated_cb cb, G_GNUC_UNUSED void *udata )
+{
+}
+void listview_set_multi_select ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED gboolean enable )
+{
+}
+void listview_set_num_elements ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED unsigned int rows )
+{
+}
+void listview_set_num_lines ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED unsigned int num_lines )
+{
+}
+void listview_set_scroll_type ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED ScrollType type )
+{
+}
+void listview_set_selected ( G_GNUC_UNUSED listview *lv, G_GNUC_UNUSED unsigned int selected )
+{
+}
+void listview_toggle_ellipsizing ( G_GNUC_UNUSED listview *lv )
+{
+}
+textbox* textbox_create ( G_GNUC_UNUSED widget *parent, G_GNUC_UNUSED WidgetType type, G_GNUC_UNUSED const char *name, G_GNUC_UNUSED TextboxFlags flags,
+                          G_GNUC_UNUSED TextBoxFontType tbft, G_GNUC_UNUSED const char *text, G_GNUC_UNUSED double xalign, G_GNUC_UNUSED double yalign )
+{
+    return NULL;
+}
+gboolean textbox_append_text ( G_GNUC_UNUSED textbox *tb, G_GNUC_UNUSED const char *pad, G_GNUC_UNUSED const int pad_len )
+{
+    return FALSE;
+}
+void textbox_cursor_end ( G_GNUC_UNUSED textbox *tb )
+{
+}
+void textbox_font ( G_GNUC_UNUSED textbox *tb, G_GNUC_UNUSED TextBoxFontType tbft )
+{
+}
+PangoAttrList *textbox_get_pango_attributes ( G_GNUC_UNUSED textbox *tb )
+{
+    return NULL;
+}
+const char *textbox_get_visible_text ( G_GNUC_UNUSED const textbox *tb )
+{
+    return NULL;
+}
+int textbox_keybinding ( G_GNUC_UNUSED textbox *tb, G_GNUC_UNUSED KeyBindingAction action )
+{
+    return 0;
+}
+void textbox_set_pango_attributes ( G_GNUC_UNUSED textbox *tb, G_GNUC_UNUSED PangoAttrList *list )
+{
+}
+void textbox_set_pango_context ( G_GNUC_UNUSED const char *font, G_GNUC_UNUSED PangoContext *p )
+{
+}
+void textbox_text ( G_GNUC_UNUSED textbox *tb, G_GNUC_UNUSED const char *text )
+{
+}
+void widget_draw ( G_GNUC_UNUSED widget *widget, G_GNUC_UNUSED cairo_t *d )
+{
+}
+widget *widget_find_mouse_target ( G_GNUC_UNUSED widget *wid, G_GNUC_UNUSED WidgetType type, G_GNUC_UNUSED gint x, G_GNUC_UNUSED gint y )
+{
+    return NULL;
+}
+void widget_free ( G_GNUC_UNUSED widget *wid )
+{
+}
+int widget_get_desired_height ( G_GNUC_UNUSED widget *wid )
+{
+    return 0;
+}
+gboolean widget_motion_notify ( G_GNUC_UNUSED widget *wid, G_GNUC_UNUSED gint x, G_GNUC_UNUSED gint y )
+{
+    return FALSE;
+}
+gboolean widget_need_redraw ( G_GNUC_UNUSED widget *wid )
+{
+    return FALSE;
+}
+void widget_queue_redraw ( G_GNUC_UNUSED widget *wid )
+{
+}
+void widget_resize ( G_GNUC_UNUSED widget *widget, G_GNUC_UNUSED short w, G_GNUC_UNUSED short h )
+{
+}
+void widget_set_enabled ( G_GNUC_UNUSED widget *widget, G_GNUC_UNUSED gboolean enabled )
+{
+}
+void widget_set_trigger_action_handler ( G_GNUC_UNUSED widget *wid, G_GNUC_UNUSED widget_trigger_action_cb cb, G_GNUC_UNUSED void *cb_data )
+{
+}
+WidgetTriggerActionResult widget_trigger_action ( G_GNUC_UNUSED widget *wid, G_GNUC_UNUSED guint action, G_GNUC_UNUSED gint x, G_GNUC_UNUSED gint y )
+{
+    return WIDGET_TRIGGER_ACTION_RESULT_IGNORED;
+}
+void widget_xy_to_relative ( G_GNUC_UNUSED widget *widget, G_GNUC_UNUSED gint *x, G_GNUC_UNUSED gint *y )
+{
+}
+
+static unsigned int test_mode_get_num_entries ( G_GNUC_UNUSED const Mode *sw )
+{
+    return test_rows->len;
+}
+
+static int test_mode_token_match ( G_GNUC_UNUSED const Mode *sw, rofi_int_matcher **tokens, unsigned int index )
+{
+    g_atomic_int_inc ( &test_match_calls );
+    return helper_token_match ( tokens, g_ptr_array_index ( test_rows, index ) );
+}
+
+static void test_mode_token_match_batch ( G_GNUC_UNUSED const Mode *sw, rofi_int_matcher **tokens, unsigned int start, unsigned int stop, unsigned int *out, unsigned int *count )
+{
+    unsigned int matched = 0;
+    g_atomic_int_inc ( &test_batch_calls );
+    g_atomic_int_add ( &test_match_calls, stop - start );
+    for ( unsigned int i = start; i < stop; i++ ) {
+        if ( helper_token_match ( tokens, g_ptr_array_index ( test_rows, i ) ) ) {
+            out[matched++] = i;
+        }
+    }
+    *count = matched;
+}
+
+static char *test_mode_get_display_value ( G_GNUC_UNUSED const Mode *sw, unsigned int index, G_GNUC_UNUSED int *state, G_GNUC_UNUSED GList **attr_list, int get_entry )
+{
+    if ( get_entry ) {
+        g_atomic_int_inc ( &test_copy_calls );
+    }
+    return get_entry ? g_strdup ( g_ptr_array_index ( test_rows, index ) ) : NULL;
+}
+
+static const char *test_mode_peek_completion ( G_GNUC_UNUSED const Mode *sw, unsigned int index, glong *length )
+{
+    const char *row = g_ptr_array_index ( test_rows, index );
+    *length = g_utf8_strlen ( row, -1 );
+    return row;
+}
+
+static const RofiStringTable *test_mode_get_string_table ( G_GNUC_UNUSED const Mode *sw )
+{
+    return helper_match_cache_get_table ( test_match_cache );
+}
+
+static Mode test_mode =
+{
+    .abi_version        = ABI_VERSION,
+    .name               = "test",
+    ._get_num_entries   = test_mode_get_num_entries,
+    ._token_match       = test_mode_token_match,
+    ._token_match_batch = test_mode_token_match_batch,
+    ._get_string_table  = test_mode_get_string_table,
+    ._peek_completion   = test_mode_peek_completion,
+    ._get_display_value = test_mode_get_display_value,
+};
+
+static void view_filter_test_setup ( void )
+{
+    config.sort            = FALSE;
+    config.matching_method = MM_NORMAL;
+    config.case_sensitive  = FALSE;
+    test_window.name       = "window";
+    test_rows              = g_ptr_array_new_with_free_func ( g_free );
+    for ( unsigned int i = 0; i < NUM_ROWS; i++ ) {
+        static const char *names[] = { "aap", "noot", "Mies" };
+        g_ptr_array_add ( test_rows, g_strdup_printf ( "%s %u", names[i % 3], i ) );
+    }
+    rofi_view_workers_initialize ();
+}
+
+static void view_filter_test_teardown ( void )
+{
+    rofi_view_workers_finalize ();
+    g_ptr_array_free ( test_rows, TRUE );
+    test_rows = NULL;
+}
+
+/**
+ * @param state The view
+ * @param input The new user input
+ *
+ * Set the input and start filtering, like a keystroke does.
+ */
+static void view_filter_type ( RofiViewState *state, const char *input )
+{
+    g_free ( state->text->text );
+    state->text->text = g_strdup ( input );
+    state->refilter   = TRUE;
+    rofi_view_maybe_update ( state );
+}
+
+/**
+ * @param state The view
+ *
+ * Wait for the filter run in progress to complete.
+ */
+static void view_filter_wait ( RofiViewState *state )
+{
+    while ( state->filter_job != NULL ) {
+        g_main_context_iteration ( NULL, TRUE );
+    }
+}
+
+/**
+ * @param state The view
+ * @param input The new user input
+ *
+ * Set the input and wait for the filter run to complete.
+ */
+static void view_filter_input ( RofiViewState *state, const char *input )
+{
+    view_filter_type ( state, input );
+    view_filter_wait ( state );
+}
+
+/**
+ * Create a view on the test mode, only the parts the filter uses are set.
+ */
+static RofiViewState *view_filter_state_new ( void )
+{
+    RofiViewState *state = g_malloc0 ( sizeof ( RofiViewState ) );
+    state->sw          = &test_mode;
+    state->main_window = (box *) &test_window;
+    state->text        = g_malloc0 ( sizeof ( textbox ) );
+    state->num_lines   = mode_get_num_entries ( state->sw );
+    state->line_map    = g_malloc0_n ( state->num_lines, sizeof ( unsigned int ) );
+    state->distance    = g_malloc0_n ( state->num_lines, sizeof ( int ) );
+    view_filter_input ( state, "" );
+    return state;
+}
+
+static void view_filter_state_free ( RofiViewState *state )
+{
+    textbox *text = state->text;
+    rofi_view_free ( state );
+    g_free ( text->text );
+    g_free ( text );
+}
+
+/**
+ * @param input The user input
+ *
+ * @returns the rows matching input, in the order of the entries.
+ */
+static GArray *view_filter_expected ( const char *input )
+{
+    GArray           *retv    = g_array_new ( FALSE, FALSE, sizeof ( unsigned int ) );
+    rofi_int_matcher **tokens = helper_tokenize ( input, config.case_sensitive );
+    for ( unsigned int i = 0; i < test_rows->len; i++ ) {
+        if ( helper_token_match ( tokens, g_ptr_array_index ( test_rows, i ) ) ) {
+            g_array_append_val ( retv, i );
+        }
+    }
+    helper_tokenize_free ( tokens );
+    return retv;
+}
+
+static int view_filter_compare_rows ( gconstpointer a, gconstpointer b )
+{
+    unsigned int ra = *( (const unsigned int *) a );
+    unsigned int rb = *( (const unsigned int *) b );
+    return ( ra > rb ) - ( ra < rb );
+}
+
+/**
+ * @param state The view
+ * @param input The user input
+ *
+ * Check the view shows the rows matching input. When sorted, only the set of rows is checked.
+ */
+static void view_filter_check ( RofiViewState *state, const char *input )
+{
+    GArray *expected = view_filter_expected ( input );
+    ck_assert_uint_eq ( state->filtered_lines, expected->len );
+    unsigned int *rows = g_memdup ( state->line_map, MAX ( state->filtered_lines, 1 ) * sizeof ( unsigned int ) );
+    if ( config.sort ) {
+        qsort ( rows, state->filtered_lines, sizeof ( unsigned int ), view_filter_compare_rows );
+    }
+    for ( unsigned int i = 0; i < expected->len; i++ ) {
+        ck_assert_uint_eq ( rows[i], g_array_index ( expected, unsigned int, i ) );
+    }
+    g_free ( rows );
+    g_array_free ( expected, TRUE );
+}
+
+START_TEST ( test_view_filter_refine )
+{
+    RofiViewState *state = view_filter_state_new ();
+    ck_assert_uint_eq ( state->filtered_lines, NUM_ROWS );
+    view_filter_input ( state, "aap" );
+    view_filter_check ( state, "aap" );
+
+    // Extending the input only matches the previous result again.
+    unsigned int previous = state->filtered_lines;
+    test_match_calls = 0;
+    view_filter_input ( state, "aap 1" );
+    view_filter_check ( state, "aap 1" );
+    ck_assert_int_eq ( test_match_calls, previous );
+
+    // A negated token matches more rows when it grows.
+    test_match_calls = 0;
+    view_filter_input ( state, "aap 1 -2" );
+    view_filter_check ( state, "aap 1 -2" );
+    ck_assert_int_eq ( test_match_calls, NUM_ROWS );
+
+    // So does a regex.
+    config.matching_method = MM_REGEX;
+    view_filter_input ( state, "aap" );
+    test_match_calls = 0;
+    view_filter_input ( state, "aap|noot" );
+    view_filter_check ( state, "aap|noot" );
+    ck_assert_int_eq ( test_match_calls, NUM_ROWS );
+
+    // Removing a character matches all rows again.
+    config.matching_method = MM_NORMAL;
+    view_filter_input ( state, "noot 12" );
+    test_match_calls = 0;
+    view_filter_input ( state, "noot 1" );
+    view_filter_check ( state, "noot 1" );
+    ck_assert_int_eq ( test_match_calls, NUM_ROWS );
+    view_filter_state_free ( state );
+}
+END_TEST
+
+START_TEST ( test_view_filter_workers )
+{
+    // Enough threads to spread the rows over several workers.
+    rofi_view_workers_finalize ();
+    config.threads = 4;
+    rofi_view_workers_initialize ();
+    RofiViewState *state = view_filter_state_new ();
+
+    // Each row is matched once, the result keeps the order of the entries.
+    test_match_calls = 0;
+    view_filter_input ( state, "mies 1" );
+    view_filter_check ( state, "mies 1" );
+    ck_assert_int_eq ( test_match_calls, NUM_ROWS );
+    view_filter_state_free ( state );
+}
+END_TEST
+
+START_TEST ( test_view_filter_cancel )
+{
+    config.sort = TRUE;
+    RofiViewState *state = view_filter_state_new ();
+
+    // The first step does not filter all rows, the previous result stays shown.
+    view_filter_type ( state, "1" );
+    ck_assert_ptr_nonnull ( state->filter_job );
+    ck_assert_uint_eq ( state->filtered_lines, NUM_ROWS );
+    for ( unsigned int i = 0; i < NUM_ROWS; i++ ) {
+        ck_assert_uint_eq ( state->line_map[i], i );
+        ck_assert_int_eq ( state->distance[i], 0 );
+    }
+
+    // New input cancels the run and starts over.
+    guint generation = state->filter_generation;
+    view_filter_type ( state, "12" );
+    ck_assert_ptr_nonnull ( state->filter_job );
+    ck_assert_uint_eq ( state->filter_generation, generation + 1 );
+    view_filter_wait ( state );
+    view_filter_check ( state, "12" );
+    view_filter_state_free ( state );
+}
+END_TEST
+
+/**
+ * Order the rows on their distance, rows with an equal distance keep the order of the entries.
+ */
+static int view_filter_compare_distance ( gconstpointer a, gconstpointer b, gpointer data )
+{
+    const int    *distance = data;
+    unsigned int ra        = *( (const unsigned int *) a );
+    unsigned int rb        = *( (const unsigned int *) b );
+    if ( distance[ra] != distance[rb] ) {
+        return ( distance[ra] < distance[rb] ) ? -1 : 1;
+    }
+    return ( ra > rb ) - ( ra < rb );
+}
+
+START_TEST ( test_view_filter_sort_best )
+{
+    config.sort                = TRUE;
+    config.sorting_method_enum = SORT_NORMAL;
+    RofiViewState *state = view_filter_state_new ();
+    const char    *input = "aap 1";
+    view_filter_input ( state, input );
+    view_filter_check ( state, input );
+
+    GArray *expected = view_filter_expected ( input );
+    int    *distance = g_malloc0_n ( NUM_ROWS, sizeof ( int ) );
+    glong  plen      = g_utf8_strlen ( input, -1 );
+    for ( unsigned int i = 0; i < expected->len; i++ ) {
+        const char *row = g_ptr_array_index ( test_rows, g_array_index ( expected, unsigned int, i ) );
+        distance[g_array_index ( expected, unsigned int, i )] = levenshtein ( input, plen, row, g_utf8_strlen ( row, -1 ) );
+    }
+    g_array_sort_with_data ( expected, view_filter_compare_distance, distance );
+    // Only the best rows have to be in order.
+    ck_assert_uint_gt ( expected->len, 100 );
+    for ( unsigned int i = 0; i < 100; i++ ) {
+        ck_assert_uint_eq ( state->line_map[i], g_array_index ( expected, unsigned int, i ) );
+    }
+    g_free ( distance );
+    g_array_free ( expected, TRUE );
+    view_filter_state_free ( state );
+}
+END_TEST
+
+START_TEST ( test_view_filter_peek_completion )
+{
+    config.sort                = TRUE;
+    config.sorting_method_enum = SORT_NORMAL;
+    RofiViewState *state = view_filter_state_new ();
+
+    // The rows are scored on the strings the mode lends, nothing is copied.
+    test_copy_calls = 0;
+    view_filter_input ( state, "noot 1" );
+    view_filter_check ( state, "noot 1" );
+    ck_assert_int_eq ( test_copy_calls, 0 );
+
+    // Modes that can not lend their strings are scored on a copy.
+    test_mode._peek_completion = NULL;
+    view_filter_input ( state, "aap 1" );
+    view_filter_check ( state, "aap 1" );
+    ck_assert_int_gt ( test_copy_calls, 0 );
+    test_mode._peek_completion = test_mode_peek_completion;
+    view_filter_state_free ( state );
+}
+END_TEST
+
+START_TEST ( test_view_filter_cache )
+{
+    RofiViewState *state = view_filter_state_new ();
+    view_filter_input ( state, "aap 1" );
+    view_filter_input ( state, "aap 12" );
+    view_filter_check ( state, "aap 12" );
+
+    // Going back to earlier input does not match the rows again.
+    test_match_calls = 0;
+    view_filter_input ( state, "aap 1" );
+    view_filter_check ( state, "aap 1" );
+    view_filter_input ( state, "aap 12" );
+    view_filter_check ( state, "aap 12" );
+    ck_assert_int_eq ( test_match_calls, 0 );
+
+    // Not with other settings.
+    config.case_sensitive = TRUE;
+    view_filter_input ( state, "aap 1" );
+    view_filter_check ( state, "aap 1" );
+    ck_assert_int_eq ( test_match_calls, NUM_ROWS );
+    view_filter_state_free ( state );
+}
+END_TEST
+
+START_TEST ( test_view_filter_batch )
+{
+    RofiViewState *state = view_filter_state_new ();
+    view_filter_input ( state, "noot 12" );
+
+    // All rows are matched again, in batches.
+    test_match_calls = 0;
+    test_batch_calls = 0;
+    view_filter_input ( state, "noot 1" );
+    view_filter_check ( state, "noot 1" );
+    ck_assert_int_eq ( test_match_calls, NUM_ROWS );
+    ck_assert_int_gt ( test_batch_calls, 0 );
+
+    // Narrowing down the result matches row by row.
+    test_batch_calls = 0;
+    view_filter_input ( state, "noot 13" );
+    view_filter_check ( state, "noot 13" );
+    ck_assert_int_eq ( test_batch_calls, 0 );
+    view_filter_state_free ( state );
+}
+END_TEST
+
+START_TEST ( test_view_filter_table )
+{
+    test_match_cache = helper_match_cache_new ();
+    for ( unsigned int i = 0; i < test_rows->len; i++ ) {
+        helper_match_cache_add ( test_match_cache, g_ptr_array_index ( test_rows, i ), -1 );
+    }
+    RofiViewState *state = view_filter_state_new ();
+
+    // Case insensitive tokens are matched on the folded strings, not through the mode.
+    test_match_calls = 0;
+    view_filter_input ( state, "mies 12" );
+    view_filter_check ( state, "mies 12" );
+    ck_assert_int_eq ( test_match_calls, 0 );
+
+    // Case sensitive regex and glob tokens are not matched against the folded strings.
+    config.case_sensitive  = TRUE;
+    config.matching_method = MM_REGEX;
+    view_filter_input ( state, "Mies 12" );
+    view_filter_check ( state, "Mies 12" );
+    ck_assert_uint_gt ( state->filtered_lines, 0 );
+    config.matching_method = MM_GLOB;
+    view_filter_input ( state, "Mies 1?" );
+    view_filter_check ( state, "Mies 1?" );
+    ck_assert_uint_gt ( state->filtered_lines, 0 );
+    view_filter_state_free ( state );
+    helper_match_cache_free ( test_match_cache );
+    test_match_cache = NULL;
+}
+END_TEST
+
+static Suite * view_filter_suite ( void )
+{
+    Suite *s = suite_create ( "ViewFilter" );
+
+    {
+        TCase *tc_filter = tcase_create ( "Filter" );
+        tcase_add_checked_fixture ( tc_filter, view_filter_test_setup, view_filter_test_teardown );
+        tcase_add_test ( tc_filter, test_view_filter_refine );
+        tcase_add_test ( tc_filter, test_view_filter_workers );
+        tcase_add_test ( tc_filter, test_view_filter_cancel );
+        tcase_add_test ( tc_filter, test_view_filter_sort_best );
+        tcase_add_test ( tc_filter, test_view_filter_peek_completion );
+        tcase_add_test ( tc_filter, test_view_filter_cache );
+        tcase_add_test ( tc_filter, test_view_filter_batch );
+        tcase_add_test ( tc_filter, test_view_filter_table );
+        suite_add_tcase ( s, tc_filter );
+    }
+    return s;
+}
+
+int main ( G_GNUC_UNUSED int argc, G_GNUC_UNUSED char **argv )
+{
+    if ( setlocale ( LC_ALL, "" ) == NULL ) {
+        fprintf ( stderr, "Failed to set locale.\n" );
+        return EXIT_FAILURE;
+    }
+
+    int     number_failed = 0;
+    Suite   *s;
+    SRunner *sr;
+
+    s  = view_filter_suite ();
+    sr = srunner_create ( s );
+
+    srunner_run_all ( sr, CK_NORMAL );
+    number_failed = srunner_ntests_failed ( sr );
+    srunner_free ( sr );
+    return ( number_failed == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}